@@ -73,6 +73,7 @@ syn match vhkActionName "\<history-playback-start\>"
 syn match vhkActionName "\<history-playback-stop\>"
 syn match vhkActionName "\<history-record-start\>"
 syn match vhkActionName "\<history-record-stop\>"
+syn match vhkActionName "\<history-rewind\>"
 syn match vhkActionName "\<keyset-joystick-toggle\>"
 syn match vhkActionName "\<media-record\>"
 syn match vhkActionName "\<media-stop\>"
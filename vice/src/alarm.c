@@ -54,6 +54,7 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = CLOCK_MAX;
+    context->next_pending_alarm = NULL;
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -85,6 +86,8 @@ void alarm_context_time_warp(alarm_context_t *context, CLOCK warp_amount,
         return;
     }
 
+    /* Shifting every pending clock by the same amount keeps the heap
+       ordered, so no re-sorting is needed.  */
     for (i = 0; i < context->num_pending_alarms; i++) {
         if (warp_direction > 0) {
             context->pending_alarms[i].clk += warp_amount;
@@ -167,6 +170,8 @@ void alarm_destroy(alarm_t *alarm)
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
+    alarm_t *moved;
+    unsigned int last;
     int idx;
 
     idx = alarm->pending_idx;
@@ -176,34 +181,33 @@ void alarm_unset(alarm_t *alarm)
     }
     context = alarm->context;
 
-    if (context->num_pending_alarms > 1) {
-        int last;
+    last = --context->num_pending_alarms;
 
-        last = --context->num_pending_alarms;
-
-        if (last != idx) {
-            /* Let's copy the struct by hand to make sure stupid compilers
-               don't do stupid things.  */
-            context->pending_alarms[idx].alarm
-                = context->pending_alarms[last].alarm;
-            context->pending_alarms[idx].clk
-                = context->pending_alarms[last].clk;
-
-            context->pending_alarms[idx].alarm->pending_idx = idx;
+    if ((unsigned int)idx != last) {
+        /* Fill the hole with the last heap entry and restore heap order.  */
+        moved = context->pending_alarms[last].alarm;
+        alarm_context_heap_store(context, (unsigned int)idx, moved,
+                                 context->pending_alarms[last].clk);
+        alarm_context_heap_up(context, (unsigned int)idx);
+        if (moved->pending_idx == idx) {
+            alarm_context_heap_down(context, (unsigned int)idx);
         }
+    }
 
-        if (context->next_pending_alarm_idx == idx) {
-            alarm_context_update_next_pending(context);
-        } else if (context->next_pending_alarm_idx == last) {
-            context->next_pending_alarm_idx = idx;
-        }
-    } else {
-        context->num_pending_alarms = 0;
-        context->next_pending_alarm_clk = CLOCK_MAX;
-        context->next_pending_alarm_idx = -1;
+    /* The alarm in the last slot takes over the slot of the removed one.
+       That only lowers its slot, so it can only move towards the leaves.  */
+    if (alarm->pending_slot != last) {
+        moved = context->pending_slots[last];
+        moved->pending_slot = alarm->pending_slot;
+        context->pending_slots[alarm->pending_slot] = moved;
+        alarm_context_heap_down(context, (unsigned int)moved->pending_idx);
     }
 
     alarm->pending_idx = -1;
+
+    if (alarm == context->next_pending_alarm) {
+        alarm_context_update_next_pending(context);
+    }
 }
 
 void alarm_log_too_many_alarms(void)
@@ -28,6 +28,8 @@
 #ifndef VICE_ALARM_H
 #define VICE_ALARM_H
 
+#include <stddef.h>
+
 #include "types.h"
 
 #define ALARM_CONTEXT_MAX_PENDING_ALARMS 0x100
@@ -49,6 +51,12 @@ struct alarm_s {
        pending.  */
     int pending_idx;
 
+    /* Position the alarm would have in a pending list that is only
+       appended to and that fills holes with its last entry.  Alarms due at
+       the same clock are dispatched in the order this gives, highest
+       first, as they were before the list became a heap.  */
+    unsigned int pending_slot;
+
     /* Call data */
     void *data;
 
@@ -74,16 +82,23 @@ struct alarm_context_s {
     /* Alarm list.  */
     struct alarm_s *alarms;
 
-    /* Pending alarm array.  Statically allocated because it's slightly
+    /* Pending alarm array, kept as a binary min-heap ordered by `clk',
+       then by `pending_slot' (highest first).  The alarm that is due first
+       is always at index 0.  Statically allocated because it's slightly
        faster this way.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
+    /* Pending alarms by `pending_slot'.  */
+    struct alarm_s *pending_slots[ALARM_CONTEXT_MAX_PENDING_ALARMS];
+
     /* Clock tick for the next pending alarm.  */
     CLOCK next_pending_alarm_clk;
 
-    /* Pending alarm number.  */
-    int next_pending_alarm_idx;
+    /* Next alarm to dispatch.  It only changes when an alarm is set to an
+       earlier clock, or when it is set again or unset itself, so of several
+       alarms due at the same clock the one chosen first stays chosen.  */
+    struct alarm_s *next_pending_alarm;
 };
 typedef struct alarm_context_s alarm_context_t;
 
@@ -109,36 +124,100 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
 
 inline static void alarm_context_update_next_pending(alarm_context_t *context)
 {
-    CLOCK next_pending_alarm_clk = CLOCK_MAX;
-    int next_pending_alarm_idx;
-    unsigned int i;
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm = context->pending_alarms[0].alarm;
+    } else {
+        context->next_pending_alarm_clk = CLOCK_MAX;
+        context->next_pending_alarm = NULL;
+    }
+}
+
+/* Return non-zero if heap slot `a' is to be dispatched before slot `b'.  */
+inline static int alarm_context_heap_before(alarm_context_t *context,
+                                            unsigned int a, unsigned int b)
+{
+    if (context->pending_alarms[a].clk != context->pending_alarms[b].clk) {
+        return context->pending_alarms[a].clk < context->pending_alarms[b].clk;
+    }
+    return context->pending_alarms[a].alarm->pending_slot
+           > context->pending_alarms[b].alarm->pending_slot;
+}
+
+/* Store `alarm' due at `clk' into heap slot `idx'.  */
+inline static void alarm_context_heap_store(alarm_context_t *context,
+                                           unsigned int idx,
+                                           alarm_t *alarm, CLOCK clk)
+{
+    context->pending_alarms[idx].alarm = alarm;
+    context->pending_alarms[idx].clk = clk;
+    alarm->pending_idx = (int)idx;
+}
 
-    next_pending_alarm_idx = context->next_pending_alarm_idx;
+/* Move the entry at heap slot `idx' towards the root until its parent is
+   dispatched before it.  */
+inline static void alarm_context_heap_up(alarm_context_t *context,
+                                        unsigned int idx)
+{
+    alarm_t *alarm = context->pending_alarms[idx].alarm;
+    CLOCK clk = context->pending_alarms[idx].clk;
 
-    for (i = 0; i < context->num_pending_alarms; i++) {
-        CLOCK pending_clk = context->pending_alarms[i].clk;
+    while (idx > 0) {
+        unsigned int parent = (idx - 1) >> 1;
 
-        if (pending_clk <= next_pending_alarm_clk) {
-            next_pending_alarm_clk = pending_clk;
-            next_pending_alarm_idx = (int)i;
+        if (context->pending_alarms[parent].clk < clk
+            || (context->pending_alarms[parent].clk == clk
+                && context->pending_alarms[parent].alarm->pending_slot > alarm->pending_slot)) {
+            break;
         }
+        alarm_context_heap_store(context, idx,
+                                 context->pending_alarms[parent].alarm,
+                                 context->pending_alarms[parent].clk);
+        idx = parent;
     }
+    alarm_context_heap_store(context, idx, alarm, clk);
+}
 
-    context->next_pending_alarm_clk = next_pending_alarm_clk;
-    context->next_pending_alarm_idx = next_pending_alarm_idx;
+/* Move the entry at heap slot `idx' towards the leaves until neither child
+   is dispatched before it.  */
+inline static void alarm_context_heap_down(alarm_context_t *context,
+                                          unsigned int idx)
+{
+    alarm_t *alarm = context->pending_alarms[idx].alarm;
+    CLOCK clk = context->pending_alarms[idx].clk;
+    unsigned int num = context->num_pending_alarms;
+
+    while (1) {
+        unsigned int child = (idx << 1) + 1;
+
+        if (child >= num) {
+            break;
+        }
+        if (child + 1 < num && alarm_context_heap_before(context, child + 1, child)) {
+            child++;
+        }
+        if (clk < context->pending_alarms[child].clk
+            || (clk == context->pending_alarms[child].clk
+                && alarm->pending_slot > context->pending_alarms[child].alarm->pending_slot)) {
+            break;
+        }
+        alarm_context_heap_store(context, idx,
+                                 context->pending_alarms[child].alarm,
+                                 context->pending_alarms[child].clk);
+        idx = child;
+    }
+    alarm_context_heap_store(context, idx, alarm, clk);
 }
 
 inline static void alarm_context_dispatch(alarm_context_t *context,
                                           CLOCK cpu_clk)
 {
     CLOCK offset;
-    int idx;
     alarm_t *alarm;
 
     offset = cpu_clk - context->next_pending_alarm_clk;
 
-    idx = context->next_pending_alarm_idx;
-    alarm = context->pending_alarms[idx].alarm;
+    alarm = context->next_pending_alarm;
 
     (alarm->callback)(offset, alarm->data);
 }
@@ -152,33 +231,42 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
     idx = alarm->pending_idx;
 
     if (idx < 0) {
-        int new_idx;
+        unsigned int new_idx;
 
         /* Not pending yet: add.  */
 
-        new_idx = (int)(context->num_pending_alarms);
-        if (new_idx >= (int)ALARM_CONTEXT_MAX_PENDING_ALARMS) {
+        new_idx = context->num_pending_alarms;
+        if (new_idx >= ALARM_CONTEXT_MAX_PENDING_ALARMS) {
             alarm_log_too_many_alarms();
             return;
         }
 
+        context->num_pending_alarms++;
+
+        alarm->pending_slot = new_idx;
+        context->pending_slots[new_idx] = alarm;
         context->pending_alarms[new_idx].alarm = alarm;
         context->pending_alarms[new_idx].clk = cpu_clk;
-
-        context->num_pending_alarms++;
+        alarm_context_heap_up(context, new_idx);
 
         if (cpu_clk < context->next_pending_alarm_clk) {
             context->next_pending_alarm_clk = cpu_clk;
-            context->next_pending_alarm_idx = new_idx;
+            context->next_pending_alarm = alarm;
         }
-
-        alarm->pending_idx = new_idx;
     } else {
+        CLOCK old_clk = context->pending_alarms[idx].clk;
+
         /* Already pending: modify.  */
 
         context->pending_alarms[idx].clk = cpu_clk;
+        if (cpu_clk < old_clk) {
+            alarm_context_heap_up(context, (unsigned int)idx);
+        } else if (cpu_clk > old_clk) {
+            alarm_context_heap_down(context, (unsigned int)idx);
+        }
+
         if (context->next_pending_alarm_clk > cpu_clk
-            || idx == context->next_pending_alarm_idx) {
+            || alarm == context->next_pending_alarm) {
             alarm_context_update_next_pending(context);
         }
     }
@@ -34,6 +34,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "rewind.h"
 #include "uiactions.h"
 #include "uiapi.h"
 #include "uisnapshot.h"
@@ -108,6 +109,12 @@ static void history_milestone_reset_action(void *unused)
 {
     event_record_reset_milestone();
 }
+
+/** \brief  Rewind emulation by one second using the rewind buffer */
+static void history_rewind_action(void *unused)
+{
+    rewind_step_back_seconds(1);
+}
 /* }}} */
 
 
@@ -164,6 +171,10 @@ static const ui_action_map_t snapshot_actions[] = {
         .action  = ACTION_HISTORY_MILESTONE_RESET,
         .handler = history_milestone_reset_action
     },
+    {
+        .action  = ACTION_HISTORY_REWIND,
+        .handler = history_rewind_action
+    },
 
     UI_ACTION_MAP_TERMINATOR
 };
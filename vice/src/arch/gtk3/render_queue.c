@@ -29,35 +29,62 @@
 #include "render_queue.h"
 
 #include <assert.h>
-#include <pthread.h>
+#include <stdatomic.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "lib.h"
+#include "log.h"
 #include "vsyncapi.h"
 
-#define LOCK() pthread_mutex_lock(&rq->lock)
-#define UNLOCK() pthread_mutex_unlock(&rq->lock)
+/*
+ * Backbuffers travel between two threads: the emulation thread takes them
+ * from the pool and queues them for display, the render thread takes them
+ * from the queue and returns them to the pool. Both the queue and the pool
+ * are single-producer/single-consumer rings, so the queue itself needs no
+ * lock.
+ *
+ * The renderers do not keep to one producer per ring on their own, though:
+ * when the render thread has gone away, the emulation thread returns the
+ * buffer to the pool itself. They also call in here with the canvas lock
+ * held, which keeps the pool to one producer at a time and keeps the queue
+ * alive while it is used. The rings only spare the queue its own mutex.
+ */
 
-typedef struct vice_render_queue_s {
-    pthread_mutex_t lock;
+/** Ring capacity, a power of two larger than the number of backbuffers */
+#define RING_SIZE 4
 
-    /** Holds all currently unused backbuffers */
-    backbuffer_t *backbuffer_stack[RENDER_QUEUE_MAX_BACKBUFFERS];
+/** Number of buckets in the enqueue-to-display latency histogram */
+#define LATENCY_BUCKETS 8
 
-    /** How many unused backbuffers in the stack */
-    unsigned int backbuffer_stack_size;
+/** Upper bound of the first latency bucket in microseconds, doubling per bucket */
+#define LATENCY_FIRST_BUCKET_US 500
+
+typedef struct backbuffer_ring_s {
+    backbuffer_t *slots[RING_SIZE];
+
+    /** Next slot to read, only advanced by the consumer */
+    atomic_uint head;
+
+    /** Next slot to write, only advanced by the producer */
+    atomic_uint tail;
+} backbuffer_ring_t;
+
+typedef struct vice_render_queue_s {
+    /** Holds all currently unused backbuffers */
+    backbuffer_ring_t pool;
 
     /** Holds the queue of backbuffers ready to render */
-    backbuffer_t *render_queue[RENDER_QUEUE_MAX_BACKBUFFERS];
+    backbuffer_ring_t queue;
 
-    /** How many backbuffers in render queue */
-    unsigned int render_queue_length;
+    /** Frames dropped because no backbuffer was free (emulation thread) */
+    unsigned long frames_dropped;
 
-    /** Index of next backbuffer to render in render_queue */
-    unsigned int render_queue_next;
+    /** Frames taken for display (render thread) */
+    unsigned long frames_displayed;
 
-    /** Allows discarding of late buffer returns */
-    unsigned int backbuffer_generation;
+    /** Enqueue-to-display latency histogram (render thread) */
+    unsigned long latency[LATENCY_BUCKETS];
 } render_queue_t;
 
 static void free_backbuffer(backbuffer_t *backbuffer) {
@@ -65,6 +92,69 @@ static void free_backbuffer(backbuffer_t *backbuffer) {
     lib_free(backbuffer);
 }
 
+static bool ring_push(backbuffer_ring_t *ring, backbuffer_t *backbuffer)
+{
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head == RING_SIZE) {
+        return false;
+    }
+
+    ring->slots[tail % RING_SIZE] = backbuffer;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+static backbuffer_t *ring_pop(backbuffer_ring_t *ring)
+{
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    backbuffer_t *backbuffer;
+
+    if (head == tail) {
+        return NULL;
+    }
+
+    backbuffer = ring->slots[head % RING_SIZE];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return backbuffer;
+}
+
+static unsigned int ring_length(backbuffer_ring_t *ring)
+{
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    return tail - head;
+}
+
+static void log_latency(render_queue_t *rq)
+{
+    char line[256];
+    size_t len;
+    unsigned int bound = LATENCY_FIRST_BUCKET_US;
+    int i;
+
+    if (!rq->frames_displayed) {
+        return;
+    }
+
+    len = (size_t)snprintf(line, sizeof line, "%lu frames, %lu dropped; enqueue-to-display:",
+                           rq->frames_displayed, rq->frames_dropped);
+    for (i = 0; i < LATENCY_BUCKETS && len < sizeof line; i++) {
+        if (i < LATENCY_BUCKETS - 1) {
+            len += (size_t)snprintf(line + len, sizeof line - len, " <%uus:%lu", bound, rq->latency[i]);
+        } else {
+            len += (size_t)snprintf(line + len, sizeof line - len, " more:%lu", rq->latency[i]);
+        }
+        bound *= 2;
+    }
+    log_message(LOG_DEFAULT, "Render queue: %s", line);
+}
+
 /****/
 
 /** \brief Allocate, initialise and return a new render queue. */
@@ -75,19 +165,22 @@ void *render_queue_create(void)
     int i;
 
     rq = lib_calloc(1, sizeof(render_queue_t));
-    pthread_mutex_init(&rq->lock, NULL);
+    atomic_init(&rq->pool.head, 0);
+    atomic_init(&rq->pool.tail, 0);
+    atomic_init(&rq->queue.head, 0);
+    atomic_init(&rq->queue.tail, 0);
 
     /* Seed the pool with the maximum number of backbuffers */
     for (i = 0; i < RENDER_QUEUE_MAX_BACKBUFFERS; i++) {
 
-        bb = lib_malloc(sizeof(backbuffer_t));
+        bb = lib_calloc(1, sizeof(backbuffer_t));
         bb->pixel_data = lib_malloc(0);
         bb->pixel_data_size_bytes = 0;
         bb->width = 0;
         bb->height = 0;
         bb->pixel_aspect_ratio = 0.0f;
 
-        rq->backbuffer_stack[rq->backbuffer_stack_size++] = bb;
+        ring_push(&rq->pool, bb);
     }
 
     return rq;
@@ -97,20 +190,20 @@ void *render_queue_create(void)
 void render_queue_destroy(void *render_queue)
 {
     render_queue_t *rq = (render_queue_t *)render_queue;
-    int i;
+    backbuffer_t *bb;
+
+    log_latency(rq);
 
     /* The unused backbuffers */
-    for (i = 0; i < rq->backbuffer_stack_size; i++) {
-        free_backbuffer(rq->backbuffer_stack[i]);
+    while ((bb = ring_pop(&rq->pool)) != NULL) {
+        free_backbuffer(bb);
     }
 
     /* The backbuffers queued for rendering */
-    for (i = 0; i < rq->render_queue_length; i++) {
-        free_backbuffer(rq->render_queue[rq->render_queue_next++]);
-        rq->render_queue_next = rq->render_queue_next % RENDER_QUEUE_MAX_BACKBUFFERS;
+    while ((bb = ring_pop(&rq->queue)) != NULL) {
+        free_backbuffer(bb);
     }
 
-    pthread_mutex_destroy(&rq->lock);
     lib_free(render_queue);
 }
 
@@ -122,19 +215,13 @@ backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size
     render_queue_t *rq = (render_queue_t *)render_queue;
     backbuffer_t *bb;
 
-    LOCK();
-
-    if (!rq->backbuffer_stack_size) {
+    bb = ring_pop(&rq->pool);
+    if (!bb) {
         /* no buffers available, skip this frame */
-        UNLOCK();
+        rq->frames_dropped++;
         return NULL;
     }
 
-    bb = rq->backbuffer_stack[rq->backbuffer_stack_size - 1];
-    rq->backbuffer_stack_size--;
-
-    UNLOCK();
-
     /* Make sure there's at least the requested size in bytes */
     if (bb->pixel_data_size_bytes < pixel_data_size_bytes) {
         lib_free(bb->pixel_data);
@@ -153,51 +240,42 @@ backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size
 void render_queue_enqueue_for_display(void *render_queue, backbuffer_t *backbuffer)
 {
     render_queue_t *rq = (render_queue_t *)render_queue;
+    bool queued;
 
-    LOCK();
-
-    assert(rq->render_queue_length < RENDER_QUEUE_MAX_BACKBUFFERS);
+    backbuffer->enqueue_time = tick_now();
 
-    rq->render_queue[(rq->render_queue_next + rq->render_queue_length) % RENDER_QUEUE_MAX_BACKBUFFERS] = backbuffer;
-    rq->render_queue_length++;
-
-    UNLOCK();
+    queued = ring_push(&rq->queue, backbuffer);
+    assert(queued);
+    (void)queued;
 }
 
 unsigned int render_queue_length(void *render_queue)
 {
     render_queue_t *rq = (render_queue_t *)render_queue;
 
-    unsigned int render_queue_length;
-
-    LOCK();
-
-    render_queue_length = rq->render_queue_length;
-
-    UNLOCK();
-
-    return render_queue_length;
+    return ring_length(&rq->queue);
 }
 
 /** Obtain rendered backbuffer for display, or NULL if none available */
 backbuffer_t *render_queue_dequeue_for_display(void *render_queue)
 {
     render_queue_t *rq = (render_queue_t *)render_queue;
-    void *backbuffer;
-
-    LOCK();
+    backbuffer_t *backbuffer;
+    unsigned long latency_us;
+    unsigned long bound = LATENCY_FIRST_BUCKET_US;
+    int i;
 
-    /* Are there any available? */
-    if (!rq->render_queue_length) {
-        UNLOCK();
+    backbuffer = ring_pop(&rq->queue);
+    if (!backbuffer) {
         return NULL;
     }
 
-    backbuffer = rq->render_queue[rq->render_queue_next];
-    rq->render_queue_next = (rq->render_queue_next + 1) % RENDER_QUEUE_MAX_BACKBUFFERS;
-    rq->render_queue_length--;
-
-    UNLOCK();
+    latency_us = TICK_TO_MICRO(tick_now_delta(backbuffer->enqueue_time));
+    for (i = 0; i < LATENCY_BUCKETS - 1 && latency_us >= bound; i++) {
+        bound *= 2;
+    }
+    rq->latency[i]++;
+    rq->frames_displayed++;
 
     return backbuffer;
 }
@@ -205,13 +283,9 @@ backbuffer_t *render_queue_dequeue_for_display(void *render_queue)
 void render_queue_return_to_pool(void *render_queue, backbuffer_t *backbuffer)
 {
     render_queue_t *rq = (render_queue_t *)render_queue;
+    bool returned;
 
-    LOCK();
-
-    assert(rq->backbuffer_stack_size < RENDER_QUEUE_MAX_BACKBUFFERS);
-
-    rq->backbuffer_stack[rq->backbuffer_stack_size] = backbuffer;
-    rq->backbuffer_stack_size++;
-
-    UNLOCK();
+    returned = ring_push(&rq->pool, backbuffer);
+    assert(returned);
+    (void)returned;
 }
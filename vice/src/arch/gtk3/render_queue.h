@@ -31,6 +31,8 @@
 
 #include <stdbool.h>
 
+#include "archdep_tick.h"
+
 typedef struct {
     bool interlaced;
     int interlace_field;
@@ -39,8 +41,16 @@ typedef struct {
     unsigned int width;
     unsigned int height;
     float pixel_aspect_ratio;
+    tick_t enqueue_time;
 } backbuffer_t;
 
+/*
+ * Each ring is single-producer/single-consumer. Callers must not have two
+ * threads return buffers to the pool, or queue buffers for display, at the
+ * same time, and must keep the queue from being destroyed while another
+ * thread uses it. The GTK3 renderers do both by holding the canvas lock.
+ */
+
 void *render_queue_create(void);
 void render_queue_destroy(void *render_queue);
 
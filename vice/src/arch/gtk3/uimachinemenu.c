@@ -497,6 +497,9 @@ static ui_menu_item_t snapshot_menu[] = {
     { "Return to milestone", UI_MENU_TYPE_ITEM_ACTION,
       ACTION_HISTORY_MILESTONE_RESET,
       NULL, false },
+    { "Rewind one second", UI_MENU_TYPE_ITEM_ACTION,
+      ACTION_HISTORY_REWIND,
+      NULL, false },
 
     UI_MENU_SEPARATOR,
 
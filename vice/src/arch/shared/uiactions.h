@@ -216,6 +216,7 @@ enum {
     ACTION_HISTORY_PLAYBACK_STOP,
     ACTION_HISTORY_RECORD_START,
     ACTION_HISTORY_RECORD_STOP,
+    ACTION_HISTORY_REWIND,
     ACTION_HOTKEYS_CLEAR,
     ACTION_HOTKEYS_DEFAULT,
     ACTION_HOTKEYS_LOAD,
@@ -598,6 +598,7 @@ static int attach_disk_image(disk_image_t *oldimage, vdrive_t *vdrive,
     new_image.gcr = NULL;
     new_image.p64 = lib_calloc(1, sizeof(TP64Image));
     new_image.read_only = (unsigned int)attach_device_readonly_enabled[unit - 8][drive];
+    new_image.generation = 0;
 
     switch (devicetype) {
         case ATTACH_DEVICE_NONE:
@@ -83,6 +83,13 @@ static int force_c64_mode = 0;
 
 static int mmu_config64 = 0;
 
+/* CPU switch statistics, shown by the monitor (`io d500').  */
+static unsigned long mmu_switches_to_z80 = 0;
+static unsigned long mmu_switches_to_8502 = 0;
+static CLOCK mmu_cpu_cycles_z80 = 0;
+static CLOCK mmu_cpu_cycles_8502 = 0;
+static CLOCK mmu_cpu_switch_clk = 0;
+
 /* Logging goes here.  */
 static log_t mmu_log = LOG_ERR;
 
@@ -247,6 +254,20 @@ static int mmu_4080_key_event(int pressed)
     return pressed;
 }
 
+/* Add the cycles since the last switch to the CPU that ran them.  */
+static void mmu_count_cpu_cycles(int cpu_8502)
+{
+    /* the clock goes back when a snapshot is restored */
+    if (maincpu_clk > mmu_cpu_switch_clk) {
+        if (cpu_8502) {
+            mmu_cpu_cycles_8502 += maincpu_clk - mmu_cpu_switch_clk;
+        } else {
+            mmu_cpu_cycles_z80 += maincpu_clk - mmu_cpu_switch_clk;
+        }
+    }
+    mmu_cpu_switch_clk = maincpu_clk;
+}
+
 static void mmu_switch_cpu(int value)
 {
     if (value) {
@@ -499,6 +520,12 @@ void mmu_store(uint16_t address, uint8_t value)
             case 5: /* Mode configuration register (MCR).  */
                 value = (value & 0x7f) | 0x30;
                 if ((value & 1) ^ (oldvalue & 1)) {
+                    mmu_count_cpu_cycles(oldvalue & 1);
+                    if (value & 1) {
+                        mmu_switches_to_8502++;
+                    } else {
+                        mmu_switches_to_z80++;
+                    }
                     mmu_switch_cpu(value & 1);
                 }
                 if (((value & 0x40) ^ (oldvalue & 0x40)) && (value & 0x40)) {
@@ -509,6 +536,13 @@ void mmu_store(uint16_t address, uint8_t value)
                    force_c64_mode = 0;
                 }
                 c128fastiec_fast_cpu_direction(value & 8);
+                /* The CPU and the fast serial direction do not take part in
+                   the memory configuration, only the C64 mode bit does.
+                   CP/M switches CPUs for every BIOS call that needs the
+                   8502, so do not rebuild the configuration for those.  */
+                if (!((value ^ oldvalue) & 0x40)) {
+                    return;
+                }
                 break;
             case 6: /* RAM configuration register (RCR).  */
                 mmu_set_dma_bank(value);
@@ -605,6 +639,8 @@ void mmu_ffxx_store(uint16_t addr, uint8_t value)
 
 int mmu_dump(void *context, uint16_t addr)
 {
+    CLOCK total;
+
     mon_out("CR: bank: %d, $4000-$7FFF: %s, $8000-$BFFF: %s, $C000-$CFFF: %s, $D000-$DFFF: %s, $E000-$FFFF: %s\n",
             (mmu[0] & 0xc0) >> 6,
             (mmu[0] & 2) ? "RAM" : "BASIC ROM low",
@@ -665,6 +701,14 @@ int mmu_dump(void *context, uint16_t addr)
 
     mon_out("MMU version: %d\n", mmu[11] & 0xf);
     mon_out("Amount of 64KiB blocks present: %d\n", (c128_full_banks) ? 4 : 2);
+
+    mmu_count_cpu_cycles(mmu[5] & 1);
+    total = mmu_cpu_cycles_z80 + mmu_cpu_cycles_8502;
+    mon_out("CPU switches since reset: %lu to Z80, %lu to 8502\n",
+            mmu_switches_to_z80, mmu_switches_to_8502);
+    mon_out("CPU cycles since reset: Z80 %"PRIu64" (%.1f%%), 8502 %"PRIu64" (%.1f%%)\n",
+            mmu_cpu_cycles_z80, total ? 100.0 * mmu_cpu_cycles_z80 / total : 0.0,
+            mmu_cpu_cycles_8502, total ? 100.0 * mmu_cpu_cycles_8502 / total : 0.0);
     return 0;
 }
 
@@ -686,6 +730,12 @@ void mmu_reset(void)
     for (i = 0; i < 0xb; i++) {
         mmu[i] = 0;
     }
+    /* the Z80 runs after reset */
+    mmu_switches_to_z80 = 0;
+    mmu_switches_to_8502 = 0;
+    mmu_cpu_cycles_z80 = 0;
+    mmu_cpu_cycles_8502 = 0;
+    mmu_cpu_switch_clk = maincpu_clk;
     /* defaults */
     mmu[7] = 0;
     c128_mem_set_mmu_page_0(mmu[7]);
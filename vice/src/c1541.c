@@ -106,6 +106,8 @@
 
 #ifdef UNIX_COMPILE
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #endif
 
 /* #define DEBUG_DRIVE */
@@ -187,6 +189,7 @@ static int translate_fsimage_error(int err);
 /* command handlers */
 static int attach_cmd(int nargs, char **args);
 static int bam_cmd(int nargs, char **args);
+static int batch_cmd(int nargs, char **args);
 static int bcopy_cmd(int nargs, char **args);
 static int bfill_cmd(int nargs, char **args);
 static int block_cmd(int nargs, char **args);
@@ -205,6 +208,7 @@ static int format_cmd(int nargs, char **args);
 static int help_cmd(int nargs, char **args);
 static int info_cmd(int nargs, char **args);
 static int list_cmd(int nargs, char **args);
+static int mmap_cmd(int nargs, char **args);
 static int name_cmd(int nargs, char **args);
 static int p00save_cmd(int nargs, char **args);
 static int pwd_cmd(int nargs, char **args);
@@ -296,6 +300,13 @@ const command_t command_list[] = {
       "<track-max>",
       0, 3,
       bam_cmd },
+    { "batch",
+      "batch <manifest> <script> [<jobs> [json|csv]]",
+      "Run the commands in <script> on each image listed in <manifest>, using\n"
+      "<jobs> worker processes (default 1). The results are written to stdout\n"
+      "in manifest order as JSON (default) or CSV.",
+      2, 4,
+      batch_cmd },
     { "bcopy",
       "bcopy <src-track> <src-sector> <dst-track> <dst-sector> [<src-unit> "
       "[<dst-unit>]]",
@@ -433,6 +444,13 @@ const command_t command_list[] = {
       "List files matching <pattern> (default is all files).",
       0, 1,
       list_cmd },
+    { "mmap",
+      "mmap <off|read|cow>",
+      "Access images attached from now on through a memory mapping: `read'\n"
+      "serves reads from the mapping, `cow' also keeps writes in memory and\n"
+      "writes them back in bulk when the image is detached.",
+      1, 1,
+      mmap_cmd },
     { "name",
       "name <diskname>[,<id>] <unit>",
       "Change image name.",
@@ -1505,6 +1523,492 @@ static int bam_cmd(int nargs, char **args)
 }
 
 
+/** \brief  Output formats of the `batch` command */
+enum {
+    BATCH_FORMAT_JSON,  /**< one JSON object per image */
+    BATCH_FORMAT_CSV    /**< one CSV row per command */
+};
+
+/** \brief  Maximum length of a line in a batch manifest or script */
+#define BATCH_LINE_MAX  1024
+
+
+/** \brief  Read the non-empty, non-comment lines of \a path
+ *
+ * \param[in]   path    file to read
+ * \param[out]  count   number of lines read
+ *
+ * \return  list of lines, free with batch_free_lines(), or NULL on error
+ */
+static char **batch_read_lines(const char *path, int *count)
+{
+    FILE *fp;
+    char buffer[BATCH_LINE_MAX];
+    char **lines = NULL;
+    int size = 0;
+
+    *count = 0;
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "cannot open `%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    while (fgets(buffer, sizeof buffer, fp) != NULL) {
+        char *s = buffer;
+        size_t len;
+
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        len = strlen(s);
+        while (len > 0 && (s[len - 1] == '\n' || s[len - 1] == '\r'
+                    || s[len - 1] == ' ' || s[len - 1] == '\t')) {
+            s[--len] = '\0';
+        }
+        if (len == 0 || *s == '#') {
+            continue;
+        }
+        if (*count == size) {
+            size = size == 0 ? 64 : size * 2;
+            lines = lib_realloc(lines, sizeof *lines * (size_t)size);
+        }
+        lines[(*count)++] = lib_strdup(s);
+    }
+    fclose(fp);
+
+    if (lines == NULL) {
+        lines = lib_malloc(sizeof *lines);
+    }
+    return lines;
+}
+
+
+/** \brief  Free list of lines returned by batch_read_lines()
+ *
+ * \param[in]   lines   list of lines
+ * \param[in]   count   number of lines in \a lines
+ */
+static void batch_free_lines(char **lines, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        lib_free(lines[i]);
+    }
+    lib_free(lines);
+}
+
+
+/** \brief  Write \a s to \a fp as a JSON string
+ *
+ * Bytes outside of the ASCII range are written as Latin-1 code points, so
+ * the output stays valid whatever PETSCII conversion produced.
+ *
+ * \param[in]   fp  output file
+ * \param[in]   s   string
+ * \param[in]   len length of \a s
+ */
+static void batch_write_json_string(FILE *fp, const char *s, size_t len)
+{
+    size_t i;
+
+    fputc('"', fp);
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+
+        switch (c) {
+            case '"':
+                fputs("\\\"", fp);
+                break;
+            case '\\':
+                fputs("\\\\", fp);
+                break;
+            case '\n':
+                fputs("\\n", fp);
+                break;
+            case '\r':
+                fputs("\\r", fp);
+                break;
+            case '\t':
+                fputs("\\t", fp);
+                break;
+            default:
+                if (c < 0x20 || c >= 0x7f) {
+                    fprintf(fp, "\\u%04x", c);
+                } else {
+                    fputc(c, fp);
+                }
+                break;
+        }
+    }
+    fputc('"', fp);
+}
+
+
+/** \brief  Write \a s to \a fp as a quoted CSV field
+ *
+ * \param[in]   fp  output file
+ * \param[in]   s   string
+ * \param[in]   len length of \a s
+ */
+static void batch_write_csv_string(FILE *fp, const char *s, size_t len)
+{
+    size_t i;
+
+    fputc('"', fp);
+    for (i = 0; i < len; i++) {
+        if (s[i] == '"') {
+            fputc('"', fp);
+        }
+        fputc(s[i], fp);
+    }
+    fputc('"', fp);
+}
+
+
+/** \brief  Write the result of a single batch command to \a fp
+ *
+ * \param[in]   fp      output file
+ * \param[in]   format  output format (BATCH_FORMAT_JSON or BATCH_FORMAT_CSV)
+ * \param[in]   image   image file name
+ * \param[in]   command command line
+ * \param[in]   status  command status: FD_OK (0) on success, -1 or one of
+ *                      the negative FD_* codes on error
+ * \param[in]   output  captured output of the command
+ * \param[in]   len     length of \a output
+ * \param[in]   first   this is the first command of \a image
+ */
+static void batch_write_result(FILE *fp, int format, const char *image,
+                               const char *command, int status,
+                               const char *output, size_t len, int first)
+{
+    if (format == BATCH_FORMAT_CSV) {
+        batch_write_csv_string(fp, image, strlen(image));
+        fputc(',', fp);
+        batch_write_csv_string(fp, command, strlen(command));
+        fprintf(fp, ",%d,", status);
+        batch_write_csv_string(fp, output, len);
+        fputc('\n', fp);
+    } else {
+        if (!first) {
+            fputc(',', fp);
+        }
+        fputs("{\"command\":", fp);
+        batch_write_json_string(fp, command, strlen(command));
+        fprintf(fp, ",\"status\":%d,\"output\":", status);
+        batch_write_json_string(fp, output, len);
+        fputc('}', fp);
+    }
+}
+
+
+#ifdef UNIX_COMPILE
+/** \brief  Redirect stdout and stderr into a temporary file
+ *
+ * \param[out]  saved   duplicates of the original stdout and stderr
+ *
+ * \return  temporary file, or NULL when the output cannot be captured
+ */
+static FILE *batch_capture_begin(int saved[2])
+{
+    FILE *tmp = tmpfile();
+
+    if (tmp == NULL) {
+        return NULL;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    saved[0] = dup(STDOUT_FILENO);
+    saved[1] = dup(STDERR_FILENO);
+    dup2(fileno(tmp), STDOUT_FILENO);
+    dup2(fileno(tmp), STDERR_FILENO);
+    return tmp;
+}
+
+
+/** \brief  Restore stdout and stderr and return the captured output
+ *
+ * \param[in]   tmp     temporary file returned by batch_capture_begin()
+ * \param[in]   saved   duplicates of the original stdout and stderr
+ * \param[out]  len     length of the captured output
+ *
+ * \return  captured output, free with lib_free()
+ */
+static char *batch_capture_end(FILE *tmp, int saved[2], size_t *len)
+{
+    char *output;
+    long size;
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved[0], STDOUT_FILENO);
+    dup2(saved[1], STDERR_FILENO);
+    close(saved[0]);
+    close(saved[1]);
+
+    fseek(tmp, 0, SEEK_END);
+    size = ftell(tmp);
+    if (size < 0) {
+        size = 0;
+    }
+    output = lib_malloc((size_t)size + 1);
+    rewind(tmp);
+    *len = fread(output, 1, (size_t)size, tmp);
+    output[*len] = '\0';
+    fclose(tmp);
+    return output;
+}
+#endif
+
+
+/** \brief  Run a batch script on a single image
+ *
+ * The image is attached to the current unit, every line of the script is
+ * executed with its output captured, and the image is detached again.
+ *
+ * \param[in]   fp      output file for the results
+ * \param[in]   format  output format
+ * \param[in]   image   image file name
+ * \param[in]   script  script lines
+ * \param[in]   nlines  number of lines in \a script
+ */
+static void batch_run_image(FILE *fp, int format, const char *image,
+                            char **script, int nlines)
+{
+    char *argv[MAXARG + 1];
+    char *path = NULL;
+    char *output;
+    size_t len = 0;
+    int nargv;
+    int status;
+    int i;
+#ifdef UNIX_COMPILE
+    int saved[2];
+    FILE *tmp;
+#endif
+
+    memset(argv, 0, sizeof argv);
+
+    if (format == BATCH_FORMAT_JSON) {
+        fputs("{\"image\":", fp);
+        batch_write_json_string(fp, image, strlen(image));
+        fputs(",\"results\":[", fp);
+    }
+
+    /* attach the image, reporting failure as the result of an `attach` */
+#ifdef UNIX_COMPILE
+    tmp = batch_capture_begin(saved);
+#endif
+    archdep_expand_path(&path, image);
+    status = open_disk_image(drives[drive_index], path,
+                             (unsigned int)drive_index + DRIVE_UNIT_MIN);
+    lib_free(path);
+#ifdef UNIX_COMPILE
+    if (tmp != NULL) {
+        output = batch_capture_end(tmp, saved, &len);
+    } else
+#endif
+    {
+        output = lib_strdup("");
+    }
+    if (status < 0) {
+        batch_write_result(fp, format, image, "attach", -1, output, len, 1);
+        lib_free(output);
+        if (format == BATCH_FORMAT_JSON) {
+            fputs("]}\n", fp);
+        }
+        return;
+    }
+    lib_free(output);
+
+    for (i = 0; i < nlines; i++) {
+#ifdef UNIX_COMPILE
+        tmp = batch_capture_begin(saved);
+#endif
+        if (split_args(script[i], &nargv, argv) < 0) {
+            status = -1;
+        } else if (nargv == 0) {
+            status = 0;
+        } else {
+            int match = lookup_command(argv[0]);
+
+            if (match >= 0 && (command_list[match].func == quit_cmd
+                        || command_list[match].func == batch_cmd)) {
+                fprintf(stderr, "command `%s' not allowed in a batch script\n",
+                        argv[0]);
+                status = -1;
+            } else {
+                status = lookup_and_execute_command(nargv, argv);
+            }
+        }
+        len = 0;
+#ifdef UNIX_COMPILE
+        if (tmp != NULL) {
+            output = batch_capture_end(tmp, saved, &len);
+        } else
+#endif
+        {
+            output = lib_strdup("");
+        }
+        batch_write_result(fp, format, image, script[i], status, output, len,
+                           i == 0);
+        lib_free(output);
+    }
+
+    if (format == BATCH_FORMAT_JSON) {
+        fputs("]}\n", fp);
+    }
+
+    close_disk_image(drives[drive_index], drive_index + DRIVE_UNIT_MIN);
+
+    for (i = 0; i <= MAXARG; i++) {
+        if (argv[i] != NULL) {
+            lib_free(argv[i]);
+        }
+    }
+}
+
+
+/** \brief  Run a command script on every image of a manifest
+ *
+ * Syntax: `batch <manifest> <script> [<jobs> [json|csv]]`
+ *
+ * The manifest lists one image per line, the script one c1541 command per
+ * line; empty lines and lines starting with `#` are ignored in both. Each
+ * image is attached in turn to the current unit (replacing any image
+ * attached there), the script is executed and the image is detached again.
+ * The results are written to stdout in manifest order: one JSON object per
+ * image or one CSV row per command.
+ *
+ * With more than one job, the images are distributed over that many worker
+ * processes, each handling every n-th image. This avoids starting c1541
+ * once per image from a shell loop, and uses all cores for large sets.
+ *
+ * \param[in]   nargs   argument count
+ * \param[in]   args    argument list
+ *
+ * \return  FD_OK on success, FD_NOTRD if the manifest or script cannot be
+ *          read, FD_BADVAL on invalid jobs or format
+ */
+static int batch_cmd(int nargs, char **args)
+{
+    char **images;
+    char **script;
+    int nimages;
+    int nlines;
+    int jobs = 1;
+    int format = BATCH_FORMAT_JSON;
+    int i;
+
+    if (nargs > 3) {
+        if (arg_to_int(args[3], &jobs) < 0 || jobs < 1) {
+            return FD_BADVAL;
+        }
+    }
+    if (nargs > 4) {
+        if (strcmp(args[4], "json") == 0) {
+            format = BATCH_FORMAT_JSON;
+        } else if (strcmp(args[4], "csv") == 0) {
+            format = BATCH_FORMAT_CSV;
+        } else {
+            return FD_BADVAL;
+        }
+    }
+
+    images = batch_read_lines(args[1], &nimages);
+    if (images == NULL) {
+        return FD_NOTRD;
+    }
+    script = batch_read_lines(args[2], &nlines);
+    if (script == NULL) {
+        batch_free_lines(images, nimages);
+        return FD_NOTRD;
+    }
+
+    close_disk_image(drives[drive_index], drive_index + DRIVE_UNIT_MIN);
+
+    if (jobs > nimages) {
+        jobs = nimages;
+    }
+#ifndef UNIX_COMPILE
+    jobs = 1;
+#endif
+
+    if (format == BATCH_FORMAT_CSV) {
+        printf("image,command,status,output\n");
+    }
+
+#ifdef UNIX_COMPILE
+    if (jobs > 1) {
+        FILE **results = lib_calloc((size_t)jobs, sizeof *results);
+        pid_t *pids = lib_calloc((size_t)jobs, sizeof *pids);
+        int workers;
+
+        /* each worker writes a NUL-terminated record per image into its own
+         * temporary file, the records are merged back into manifest order
+         * once all workers are done */
+        fflush(stdout);
+        fflush(stderr);
+        for (workers = 0; workers < jobs; workers++) {
+            results[workers] = tmpfile();
+            if (results[workers] == NULL) {
+                break;
+            }
+            pids[workers] = fork();
+            if (pids[workers] < 0) {
+                fclose(results[workers]);
+                results[workers] = NULL;
+                break;
+            }
+            if (pids[workers] == 0) {
+                for (i = workers; i < nimages; i += jobs) {
+                    batch_run_image(results[workers], format, images[i],
+                                    script, nlines);
+                    fputc('\0', results[workers]);
+                }
+                fflush(results[workers]);
+                _exit(0);
+            }
+        }
+
+        /* images of workers that could not be started are done here */
+        for (i = 0; i < workers; i++) {
+            waitpid(pids[i], NULL, 0);
+            rewind(results[i]);
+        }
+        for (i = 0; i < nimages; i++) {
+            int w = i % jobs;
+            int c;
+
+            if (w >= workers) {
+                batch_run_image(stdout, format, images[i], script, nlines);
+                continue;
+            }
+            while ((c = fgetc(results[w])) != EOF && c != '\0') {
+                putchar(c);
+            }
+        }
+        for (i = 0; i < workers; i++) {
+            fclose(results[i]);
+        }
+        lib_free(results);
+        lib_free(pids);
+    } else
+#endif
+    {
+        for (i = 0; i < nimages; i++) {
+            batch_run_image(stdout, format, images[i], script, nlines);
+        }
+    }
+    fflush(stdout);
+
+    batch_free_lines(images, nimages);
+    batch_free_lines(script, nlines);
+    return FD_OK;
+}
+
+
 /** \brief  Copy block to another block
  *
  * Copies a single block (sector) to another block, optionally between different
@@ -3565,6 +4069,30 @@ static int list_cmd(int nargs, char **args)
 }
 
 
+/** \brief  Set the memory mapping mode for images attached from now on
+ *
+ * Syntax: mmap off|read|cow
+ *
+ * \param[in]   nargs   argument count
+ * \param[in]   args    argument list
+ *
+ * \return 0 on succes, `FD_BADVAL` on an unknown mode
+ */
+static int mmap_cmd(int nargs, char **args)
+{
+    if (strcmp(args[1], "off") == 0) {
+        disk_image_fsimage_map_mode_set(DISK_IMAGE_MAP_NONE);
+    } else if (strcmp(args[1], "read") == 0) {
+        disk_image_fsimage_map_mode_set(DISK_IMAGE_MAP_READ);
+    } else if (strcmp(args[1], "cow") == 0) {
+        disk_image_fsimage_map_mode_set(DISK_IMAGE_MAP_COW);
+    } else {
+        return FD_BADVAL;
+    }
+    return FD_OK;
+}
+
+
 /** \brief  Change disk name and id
  *
  * Syntax: name "diskname[,id]" [unit]
@@ -25,6 +25,7 @@
 
 #include "vice.h"
 
+#include "c64mem.h"
 #include "maincpu.h"
 #include "mem.h"
 
@@ -101,13 +102,13 @@ inline static void memmap_mem_update(unsigned int addr, int write)
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1);
-    (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
+    mem_store_ram_or_tab(addr, (uint8_t)(value));
 }
 
 static uint8_t memmap_mem_read(unsigned int addr)
 {
     memmap_mem_update(addr, 0);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    return mem_read_ram_or_tab(addr);
 }
 
 static void memmap_mark_read(unsigned int addr)
@@ -126,6 +127,12 @@ static uint8_t memmap_mem_read_dummy(unsigned int addr)
     memmap_mem_update(addr, 0);
     return (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
 }
+#else
+#define STORE(addr, value) \
+    mem_store_ram_or_tab((addr), (uint8_t)(value))
+
+#define LOAD(addr) \
+    mem_read_ram_or_tab((addr))
 #endif
 
 static void check_and_run_alternate_cpu(void)
@@ -78,6 +78,88 @@ static io_source_list_t c64io_dd00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_de00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_df00_head = { NULL, NULL, NULL };
 
+/* For every address of an I/O page the only device registered there, NULL
+   when there is none, or &io_dispatch_multiple when several devices overlap
+   and the list has to be walked.  Rebuilt whenever a device of the page is
+   (un)registered, so devices must unregister and register again when they
+   move, as they already do.  Whether a device is currently readable or
+   writable and valid is still checked on every access.  */
+typedef struct io_dispatch_s {
+    uint16_t page;
+    io_source_list_t *head;
+    io_source_list_t *device[0x100];
+} io_dispatch_t;
+
+static io_source_list_t io_dispatch_multiple = { NULL, NULL, NULL };
+
+static io_dispatch_t c64io_d000_dispatch = { 0xd000, &c64io_d000_head, { NULL } };
+static io_dispatch_t c64io_d100_dispatch = { 0xd100, &c64io_d100_head, { NULL } };
+static io_dispatch_t c64io_d200_dispatch = { 0xd200, &c64io_d200_head, { NULL } };
+static io_dispatch_t c64io_d300_dispatch = { 0xd300, &c64io_d300_head, { NULL } };
+static io_dispatch_t c64io_d400_dispatch = { 0xd400, &c64io_d400_head, { NULL } };
+static io_dispatch_t c64io_d500_dispatch = { 0xd500, &c64io_d500_head, { NULL } };
+static io_dispatch_t c64io_d600_dispatch = { 0xd600, &c64io_d600_head, { NULL } };
+static io_dispatch_t c64io_d700_dispatch = { 0xd700, &c64io_d700_head, { NULL } };
+static io_dispatch_t c64io_dd00_dispatch = { 0xdd00, &c64io_dd00_head, { NULL } };
+static io_dispatch_t c64io_de00_dispatch = { 0xde00, &c64io_de00_head, { NULL } };
+static io_dispatch_t c64io_df00_dispatch = { 0xdf00, &c64io_df00_head, { NULL } };
+
+static io_dispatch_t * const io_dispatch_list[] = {
+    &c64io_d000_dispatch,
+    &c64io_d100_dispatch,
+    &c64io_d200_dispatch,
+    &c64io_d300_dispatch,
+    &c64io_d400_dispatch,
+    &c64io_d500_dispatch,
+    &c64io_d600_dispatch,
+    &c64io_d700_dispatch,
+    &c64io_dd00_dispatch,
+    &c64io_de00_dispatch,
+    &c64io_df00_dispatch,
+    NULL
+};
+
+static void io_dispatch_update(io_source_list_t *head)
+{
+    io_dispatch_t *dispatch = NULL;
+    io_source_list_t *current;
+    unsigned int addr, end, i;
+
+    for (i = 0; io_dispatch_list[i] != NULL; i++) {
+        if (io_dispatch_list[i]->head == head) {
+            dispatch = io_dispatch_list[i];
+            break;
+        }
+    }
+    if (dispatch == NULL) {
+        return;
+    }
+
+    memset(dispatch->device, 0, sizeof(dispatch->device));
+
+    for (current = head->next; current != NULL; current = current->next) {
+        end = current->device->end_address;
+        if (end > dispatch->page + 0xffU) {
+            end = dispatch->page + 0xffU;
+        }
+        for (addr = current->device->start_address; addr <= end; addr++) {
+            if (dispatch->device[addr & 0xff] == NULL) {
+                dispatch->device[addr & 0xff] = current;
+            } else {
+                dispatch->device[addr & 0xff] = &io_dispatch_multiple;
+            }
+        }
+    }
+}
+
+static inline io_source_list_t *io_dispatch_lookup(io_dispatch_t *dispatch, uint16_t addr)
+{
+    if ((addr & 0xff00) != dispatch->page) {
+        return &io_dispatch_multiple;
+    }
+    return dispatch->device[addr & 0xff];
+}
+
 static void io_source_detach(io_source_detach_t *source)
 {
     switch (source->det_id) {
@@ -292,9 +374,10 @@ static void io_source_log_collisions(uint16_t addr, int amount, io_source_list_t
     }
 }
 
-static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
+static inline uint8_t io_read(io_dispatch_t *dispatch, uint16_t addr)
 {
-    io_source_list_t *current = list->next;
+    io_source_list_t *list = dispatch->head;
+    io_source_list_t *current;
     int io_source_counter = 0;
     int io_source_valid = 0;
     uint8_t realval = 0;
@@ -304,6 +387,19 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
 
     vicii_handle_pending_alarms_external(0);
 
+    /* a single device can not collide with anything */
+    current = io_dispatch_lookup(dispatch, addr);
+    if (current != &io_dispatch_multiple) {
+        if (current != NULL && current->device->read != NULL) {
+            retval = current->device->read((uint16_t)(addr & current->device->address_mask));
+            if (current->device->io_source_valid) {
+                return retval;
+            }
+        }
+        return vicii_read_phi1();
+    }
+
+    current = list->next;
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -390,15 +486,25 @@ static inline uint8_t io_peek(io_source_list_t *list, uint16_t addr)
     return vicii_read_phi1();
 }
 
-static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value)
+static inline void io_store(io_dispatch_t *dispatch, uint16_t addr, uint8_t value)
 {
     int writes = 0;
     uint16_t addy = 0xffff;
-    io_source_list_t *current = list->next;
+    io_source_list_t *current;
     void (*store)(uint16_t address, uint8_t data) = NULL;
 
     vicii_handle_pending_alarms_external_write();
 
+    current = io_dispatch_lookup(dispatch, addr);
+    if (current != &io_dispatch_multiple) {
+        if (current != NULL && current->device->store != NULL) {
+            current->device->store((uint16_t)(addr & current->device->address_mask), value);
+        }
+        return;
+    }
+
+    current = dispatch->head->next;
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -424,6 +530,7 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
 
 io_source_list_t *io_source_register(io_source_t *device)
 {
+    io_source_list_t *head;
     io_source_list_t *current = NULL;
     io_source_list_t *retval = lib_malloc(sizeof(io_source_list_t));
 
@@ -473,6 +580,7 @@ io_source_list_t *io_source_register(io_source_t *device)
             break;
     }
 
+    head = current;
     while (current->next != NULL) {
         current = current->next;
     }
@@ -482,12 +590,15 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->next = NULL;
     retval->device->order = order++;
 
+    io_dispatch_update(head);
+
     return retval;
 }
 
 void io_source_unregister(io_source_list_t *device)
 {
     io_source_list_t *prev;
+    io_source_list_t *head;
 
     assert(device != NULL);
     DBG(("IO: unregister id:%d name:%s\n", device->device->cart_id, device->device->name));
@@ -506,6 +617,13 @@ void io_source_unregister(io_source_list_t *device)
     }
 
     lib_free(device);
+
+    /* the start address may have been changed already, find the list head */
+    head = prev;
+    while (head->previous != NULL) {
+        head = head->previous;
+    }
+    io_dispatch_update(head);
 }
 
 void cartio_shutdown(void)
@@ -589,7 +707,7 @@ void cartio_set_highest_order(unsigned int nr)
 uint8_t c64io_d000_read(uint16_t addr)
 {
     DBGRW(("IO: io-d000 r %04x\n", addr));
-    return io_read(&c64io_d000_head, addr);
+    return io_read(&c64io_d000_dispatch, addr);
 }
 
 uint8_t c64io_d000_peek(uint16_t addr)
@@ -601,13 +719,13 @@ uint8_t c64io_d000_peek(uint16_t addr)
 void c64io_d000_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d000 w %04x %02x\n", addr, value));
-    io_store(&c64io_d000_head, addr, value);
+    io_store(&c64io_d000_dispatch, addr, value);
 }
 
 uint8_t c64io_d100_read(uint16_t addr)
 {
     DBGRW(("IO: io-d100 r %04x\n", addr));
-    return io_read(&c64io_d100_head, addr);
+    return io_read(&c64io_d100_dispatch, addr);
 }
 
 uint8_t c64io_d100_peek(uint16_t addr)
@@ -619,13 +737,13 @@ uint8_t c64io_d100_peek(uint16_t addr)
 void c64io_d100_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d100 w %04x %02x\n", addr, value));
-    io_store(&c64io_d100_head, addr, value);
+    io_store(&c64io_d100_dispatch, addr, value);
 }
 
 uint8_t c64io_d200_read(uint16_t addr)
 {
     DBGRW(("IO: io-d200 r %04x\n", addr));
-    return io_read(&c64io_d200_head, addr);
+    return io_read(&c64io_d200_dispatch, addr);
 }
 
 uint8_t c64io_d200_peek(uint16_t addr)
@@ -637,13 +755,13 @@ uint8_t c64io_d200_peek(uint16_t addr)
 void c64io_d200_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d200 w %04x %02x\n", addr, value));
-    io_store(&c64io_d200_head, addr, value);
+    io_store(&c64io_d200_dispatch, addr, value);
 }
 
 uint8_t c64io_d300_read(uint16_t addr)
 {
     DBGRW(("IO: io-d300 r %04x\n", addr));
-    return io_read(&c64io_d300_head, addr);
+    return io_read(&c64io_d300_dispatch, addr);
 }
 
 uint8_t c64io_d300_peek(uint16_t addr)
@@ -655,13 +773,13 @@ uint8_t c64io_d300_peek(uint16_t addr)
 void c64io_d300_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d300 w %04x %02x\n", addr, value));
-    io_store(&c64io_d300_head, addr, value);
+    io_store(&c64io_d300_dispatch, addr, value);
 }
 
 uint8_t c64io_d400_read(uint16_t addr)
 {
     DBGRW(("IO: io-d400 r %04x\n", addr));
-    return io_read(&c64io_d400_head, addr);
+    return io_read(&c64io_d400_dispatch, addr);
 }
 
 uint8_t c64io_d400_peek(uint16_t addr)
@@ -673,13 +791,13 @@ uint8_t c64io_d400_peek(uint16_t addr)
 void c64io_d400_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d400 w %04x %02x\n", addr, value));
-    io_store(&c64io_d400_head, addr, value);
+    io_store(&c64io_d400_dispatch, addr, value);
 }
 
 uint8_t c64io_d500_read(uint16_t addr)
 {
     DBGRW(("IO: io-d500 r %04x\n", addr));
-    return io_read(&c64io_d500_head, addr);
+    return io_read(&c64io_d500_dispatch, addr);
 }
 
 uint8_t c64io_d500_peek(uint16_t addr)
@@ -691,13 +809,13 @@ uint8_t c64io_d500_peek(uint16_t addr)
 void c64io_d500_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d500 w %04x %02x\n", addr, value));
-    io_store(&c64io_d500_head, addr, value);
+    io_store(&c64io_d500_dispatch, addr, value);
 }
 
 uint8_t c64io_d600_read(uint16_t addr)
 {
     DBGRW(("IO: io-d600 r %04x\n", addr));
-    return io_read(&c64io_d600_head, addr);
+    return io_read(&c64io_d600_dispatch, addr);
 }
 
 uint8_t c64io_d600_peek(uint16_t addr)
@@ -709,13 +827,13 @@ uint8_t c64io_d600_peek(uint16_t addr)
 void c64io_d600_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d600 w %04x %02x\n", addr, value));
-    io_store(&c64io_d600_head, addr, value);
+    io_store(&c64io_d600_dispatch, addr, value);
 }
 
 uint8_t c64io_d700_read(uint16_t addr)
 {
     DBGRW(("IO: io-d700 r %04x\n", addr));
-    return io_read(&c64io_d700_head, addr);
+    return io_read(&c64io_d700_dispatch, addr);
 }
 
 uint8_t c64io_d700_peek(uint16_t addr)
@@ -727,13 +845,13 @@ uint8_t c64io_d700_peek(uint16_t addr)
 void c64io_d700_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d700 w %04x %02x\n", addr, value));
-    io_store(&c64io_d700_head, addr, value);
+    io_store(&c64io_d700_dispatch, addr, value);
 }
 
 uint8_t c64io_dd00_read(uint16_t addr)
 {
     DBGRW(("IO: io-dd00 r %04x\n", addr));
-    return io_read(&c64io_dd00_head, addr);
+    return io_read(&c64io_dd00_dispatch, addr);
 }
 
 uint8_t c64io_dd00_peek(uint16_t addr)
@@ -745,13 +863,13 @@ uint8_t c64io_dd00_peek(uint16_t addr)
 void c64io_dd00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-dd00 w %04x %02x\n", addr, value));
-    io_store(&c64io_dd00_head, addr, value);
+    io_store(&c64io_dd00_dispatch, addr, value);
 }
 
 uint8_t c64io_de00_read(uint16_t addr)
 {
     DBGRW(("IO: io-de00 r %04x\n", addr));
-    return io_read(&c64io_de00_head, addr);
+    return io_read(&c64io_de00_dispatch, addr);
 }
 
 uint8_t c64io_de00_peek(uint16_t addr)
@@ -763,13 +881,13 @@ uint8_t c64io_de00_peek(uint16_t addr)
 void c64io_de00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-de00 w %04x %02x\n", addr, value));
-    io_store(&c64io_de00_head, addr, value);
+    io_store(&c64io_de00_dispatch, addr, value);
 }
 
 uint8_t c64io_df00_read(uint16_t addr)
 {
     DBGRW(("IO: io-df00 r %04x\n", addr));
-    return io_read(&c64io_df00_head, addr);
+    return io_read(&c64io_df00_dispatch, addr);
 }
 
 uint8_t c64io_df00_peek(uint16_t addr)
@@ -781,7 +899,7 @@ uint8_t c64io_df00_peek(uint16_t addr)
 void c64io_df00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-df00 w %04x %02x\n", addr, value));
-    io_store(&c64io_df00_head, addr, value);
+    io_store(&c64io_df00_dispatch, addr, value);
 }
 
 /* ---------------------------------------------------------------------------------------------------------- */
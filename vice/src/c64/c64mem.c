@@ -97,11 +97,20 @@ store_func_ptr_t *_mem_write_tab_ptr_dummy;
 static uint8_t **_mem_read_base_tab_ptr;
 static uint32_t *mem_read_limit_tab_ptr;
 
+/* Pointers to the pages that are plain RAM in the current memory
+   configuration, NULL for all other pages.  The CPU core reads and writes
+   these pages directly instead of calling through the tables above.  */
+uint8_t **_mem_read_ram_tab_ptr;
+uint8_t **_mem_write_ram_tab_ptr;
+
 /* Memory read and write tables.  */
 static store_func_ptr_t mem_write_tab[NUM_VBANKS][NUM_CONFIGS][0x101];
 static read_func_ptr_t mem_read_tab[NUM_CONFIGS][0x101];
 static uint8_t *mem_read_base_tab[NUM_CONFIGS][0x101];
 static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
+static uint8_t *mem_read_ram_tab[NUM_CONFIGS][0x101];
+static uint8_t *mem_write_ram_tab[NUM_VBANKS][NUM_CONFIGS][0x101];
+static uint8_t *mem_ram_tab_none[0x101];
 
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
@@ -167,12 +176,17 @@ static void mem_update_tab_ptrs(int flag)
             _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
             _mem_write_tab_ptr_dummy = mem_write_tab[vbank][mem_config];
         }
+        /* every access has to go through the watchpoint functions */
+        _mem_read_ram_tab_ptr = mem_ram_tab_none;
+        _mem_write_ram_tab_ptr = mem_ram_tab_none;
     } else {
         /* all watchpoints disabled */
         _mem_read_tab_ptr = mem_read_tab[mem_config];
         _mem_write_tab_ptr = mem_write_tab[vbank][mem_config];
         _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
         _mem_write_tab_ptr_dummy = mem_write_tab[vbank][mem_config];
+        _mem_read_ram_tab_ptr = mem_read_ram_tab[mem_config];
+        _mem_write_ram_tab_ptr = mem_write_ram_tab[vbank][mem_config];
     }
 }
 
@@ -677,6 +691,22 @@ void mem_read_limit_set(unsigned int base, unsigned int index, uint32_t limit)
     mem_read_limit_tab[base][index] = limit;
 }
 
+/* Find the pages that are plain RAM in each memory configuration.  Must be
+   called after all the tables have been set up.  */
+static void mem_ram_tab_init(void)
+{
+    int i, j, k;
+
+    for (i = 0; i < NUM_CONFIGS; i++) {
+        for (j = 0; j <= 0x100; j++) {
+            mem_read_ram_tab[i][j] = (mem_read_tab[i][j] == ram_read) ? mem_ram : NULL;
+            for (k = 0; k < NUM_VBANKS; k++) {
+                mem_write_ram_tab[k][i][j] = (mem_write_tab[k][i][j] == ram_store) ? mem_ram : NULL;
+            }
+        }
+    }
+}
+
 void mem_initialize_memory(void)
 {
     int i, j, k;
@@ -783,6 +813,8 @@ void mem_initialize_memory(void)
 
     _mem_read_tab_ptr = mem_read_tab[7];
     _mem_write_tab_ptr = mem_write_tab[vbank][7];
+    _mem_read_ram_tab_ptr = mem_read_ram_tab[7];
+    _mem_write_ram_tab_ptr = mem_write_ram_tab[vbank][7];
     _mem_read_base_tab_ptr = mem_read_base_tab[7];
     mem_read_limit_tab_ptr = mem_read_limit_tab[7];
 
@@ -805,6 +837,8 @@ void mem_initialize_memory(void)
     if (board == 1) {
         mem_limit_max_init();
     }
+
+    mem_ram_tab_init();
 }
 
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -842,6 +876,7 @@ void mem_set_vbank(int new_vbank)
     /* Do not override watchpoints on vbank switches.  */
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
         _mem_write_tab_ptr = mem_write_tab[new_vbank][mem_config];
+        _mem_write_ram_tab_ptr = mem_write_ram_tab[new_vbank][mem_config];
     }
 
     vicii_set_vbank(new_vbank);
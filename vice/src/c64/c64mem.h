@@ -29,6 +29,8 @@
 #ifndef VICE_C64MEM_H
 #define VICE_C64MEM_H
 
+#include <stddef.h>
+
 #include "mem.h"
 #include "types.h"
 
@@ -62,6 +64,32 @@ void mem_set_tape_motor_in(int val);
 
 extern uint8_t mem_chargen_rom[C64_CHARGEN_ROM_SIZE];
 
+extern uint8_t **_mem_read_ram_tab_ptr;
+extern uint8_t **_mem_write_ram_tab_ptr;
+
+/* Plain RAM pages of the current memory configuration are accessed
+   directly, everything else goes through the read/store function tables.  */
+static inline uint8_t mem_read_ram_or_tab(unsigned int addr)
+{
+    uint8_t *p = _mem_read_ram_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        return p[addr];
+    }
+    return (*_mem_read_tab_ptr[addr >> 8])((uint16_t)(addr));
+}
+
+static inline void mem_store_ram_or_tab(unsigned int addr, uint8_t value)
+{
+    uint8_t *p = _mem_write_ram_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        p[addr] = value;
+    } else {
+        (*_mem_write_tab_ptr[addr >> 8])((uint16_t)(addr), value);
+    }
+}
+
 void mem_set_write_hook(int config, int page, store_func_t *f);
 void mem_read_tab_set(unsigned int base, unsigned int index, read_func_ptr_t read_func);
 void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr);
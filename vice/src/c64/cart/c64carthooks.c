@@ -3625,6 +3625,11 @@ int cartridge_snapshot_write_modules(struct snapshot_s *s)
                 break;
 
             /* "IO Slot" */
+            case CARTRIDGE_DEBUGCART:
+                if (debugcart_snapshot_write_module(s) < 0) {
+                    return -1;
+                }
+                break;
             case CARTRIDGE_DIGIMAX:
                 if (digimax_snapshot_write_module(s) < 0) {
                     return -1;
@@ -4201,6 +4206,11 @@ int cartridge_snapshot_read_modules(struct snapshot_s *s)
                 break;
 
             /* "IO Slot" */
+            case CARTRIDGE_DEBUGCART:
+                if (debugcart_snapshot_read_module(s) < 0) {
+                    goto fail2;
+                }
+                break;
             case CARTRIDGE_DIGIMAX:
                 if (digimax_snapshot_read_module(s) < 0) {
                     goto fail2;
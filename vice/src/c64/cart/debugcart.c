@@ -34,6 +34,8 @@
 #include "resources.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "snapshot.h"
+#include "testbatch.h"
 #include "archdep.h"
 
 #include "debugcart.h"
@@ -74,6 +76,11 @@ static const export_resource_t export_res = {
 static void debugcart_store(uint16_t addr, uint8_t value)
 {
     int n = (int)value;
+
+    if (testbatch_debugcart_exit(n)) {
+        return;
+    }
+
     fprintf(stdout, "DBGCART: exit(%d) cycles elapsed: %"PRIu64"\n", n, maincpu_clk);
     archdep_vice_exit(n);
 }
@@ -154,3 +161,50 @@ int debugcart_cmdline_options_init(void)
     }
     return 0;
 }
+
+/* ---------------------------------------------------------------------*/
+
+/* CARTDEBUG snapshot module format:
+
+   The module is empty, the cartridge has no state besides being enabled.
+ */
+
+static const char snap_module_name[] = "CARTDEBUG";
+#define SNAP_MAJOR   0
+#define SNAP_MINOR   0
+
+int debugcart_snapshot_write_module(snapshot_t *s)
+{
+    snapshot_module_t *m;
+
+    m = snapshot_module_create(s, snap_module_name, SNAP_MAJOR, SNAP_MINOR);
+
+    if (m == NULL) {
+        return -1;
+    }
+
+    return snapshot_module_close(m);
+}
+
+int debugcart_snapshot_read_module(snapshot_t *s)
+{
+    uint8_t vmajor, vminor;
+    snapshot_module_t *m;
+
+    m = snapshot_module_open(s, snap_module_name, &vmajor, &vminor);
+
+    if (m == NULL) {
+        return -1;
+    }
+
+    /* Do not accept versions higher than current */
+    if (snapshot_version_is_bigger(vmajor, vminor, SNAP_MAJOR, SNAP_MINOR)) {
+        snapshot_set_error(SNAPSHOT_MODULE_HIGHER_VERSION);
+        snapshot_module_close(m);
+        return -1;
+    }
+
+    snapshot_module_close(m);
+
+    return set_debugcart_enabled(1, NULL);
+}
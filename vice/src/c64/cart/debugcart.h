@@ -34,4 +34,8 @@ int debugcart_resources_init(void);
 void debugcart_resources_shutdown(void);
 void debugcart_detach(void);
 
+struct snapshot_s;
+int debugcart_snapshot_write_module(struct snapshot_s *s);
+int debugcart_snapshot_read_module(struct snapshot_s *s);
+
 #endif
@@ -910,6 +910,11 @@ void drive_cpu_trigger_reset(unsigned int dnr)
 {
 }
 
+CLOCK drive_cpu_get_idle_skipped_cycles(unsigned int dnr)
+{
+    return 0;
+}
+
 void drive_shutdown(void)
 {
 }
@@ -35,6 +35,7 @@
 #include "resources.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "testbatch.h"
 
 #include "debugcart.h"
 
@@ -74,6 +75,9 @@ void debugcart_store(uint16_t addr, uint8_t value)
 {
     int n = (int)value;
     if ((debugcart_enabled) && (addr == 0xd7ff)) {
+        if (testbatch_debugcart_exit(n)) {
+            return;
+        }
         fprintf(stdout, "DBGCART: exit(%d) cycles elapsed: %lu\n",
                 n, (unsigned long)maincpu_clk); /* CLOCK can be 32 bit or 64 bit
                                                  *  so this will kinda work
@@ -61,6 +61,11 @@
 #define DISK_IMAGE_DEVICE_REAL 1    /* opencbm */
 #define DISK_IMAGE_DEVICE_RAW  2
 
+/* How file system images are accessed, see the DiskImageMapping resource */
+#define DISK_IMAGE_MAP_NONE    0    /* through the stdio stream only */
+#define DISK_IMAGE_MAP_READ    1    /* reads from a shared read-only mapping */
+#define DISK_IMAGE_MAP_COW     2    /* private mapping, writes flushed in bulk */
+
 #ifdef HAVE_X64_IMAGE
 #define DISK_IMAGE_TYPE_X64 0
 #endif
@@ -99,6 +104,7 @@ struct disk_image_s {
     unsigned int max_half_tracks;
     struct gcr_s *gcr;
     struct TP64Image *p64;
+    unsigned int generation; /* incremented on every write to the image */
 };
 typedef struct disk_image_s disk_image_t;
 
@@ -116,6 +122,7 @@ void disk_image_resources_shutdown(void);
 void disk_image_fsimage_name_set(disk_image_t *image, const char *name);
 const char *disk_image_fsimage_name_get(const disk_image_t *image);
 void *disk_image_fsimage_fd_get(const disk_image_t *image);
+void disk_image_fsimage_map_mode_set(int mode);
 int disk_image_fsimage_create(const char *name, unsigned int type);
 int disk_image_fsimage_create_dxm(const char *name, const char *diskname, unsigned int type);
 int disk_image_fsimage_create_dhd(const char *name, const char *diskname, unsigned int type);
@@ -153,5 +160,6 @@ unsigned int disk_image_speed_map(unsigned int format, unsigned int track);
 void disk_image_attach_log(const disk_image_t *image, signed int lognum, unsigned int unit, unsigned int drive);
 void disk_image_detach_log(const disk_image_t *image, signed int lognum, unsigned int unit, unsigned int drive);
 off_t disk_image_size(const disk_image_t *image);
+void disk_image_flush_due(void);
 
 #endif
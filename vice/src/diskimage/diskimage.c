@@ -38,6 +38,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cmdline.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "fsimage-check.h"
@@ -49,6 +50,7 @@
 #include "lib.h"
 #include "log.h"
 #include "realimage.h"
+#include "resources.h"
 #include "types.h"
 #include "p64.h"
 
@@ -506,6 +508,11 @@ void *disk_image_fsimage_fd_get(const disk_image_t *image)
     return fsimage_fd_get(image);
 }
 
+void disk_image_fsimage_map_mode_set(int mode)
+{
+    fsimage_map_mode_set(mode);
+}
+
 
 int disk_image_fsimage_create(const char *name, unsigned int type)
 {
@@ -550,6 +557,7 @@ disk_image_t *disk_image_create(void)
 {
     disk_image_t *image = lib_malloc(sizeof *image);
     image->p64 = NULL;
+    image->generation = 0;
     return image;
 }
 
@@ -679,6 +687,8 @@ int disk_image_write_sector(disk_image_t *image, const uint8_t *buf, const disk_
         return -1;
     }
 
+    image->generation++;
+
     switch (image->device) {
         case DISK_IMAGE_DEVICE_FS:
             rc = fsimage_write_sector(image, buf, dadr);
@@ -710,6 +720,8 @@ int disk_image_write_half_track(disk_image_t *image, unsigned int half_track,
         return -1;
     }
 
+    image->generation++;
+
     switch (image->type) {
         case DISK_IMAGE_TYPE_P64:
             return fsimage_p64_write_half_track(image, half_track, raw);
@@ -752,22 +764,69 @@ void disk_image_init(void)
 #endif
 }
 
-int disk_image_resources_init(void)
+static int map_mode = DISK_IMAGE_MAP_NONE;
+
+/** \brief  Setter for integer resource "DiskImageMapping"
+ *
+ * \param[in]   val     DISK_IMAGE_MAP_NONE, DISK_IMAGE_MAP_READ or
+ *                      DISK_IMAGE_MAP_COW
+ * \param[in]   param   extra data (unused)
+ *
+ * \return  0 on success, -1 on failure
+ */
+static int set_map_mode(int val, void *param)
 {
+    switch (val) {
+        case DISK_IMAGE_MAP_NONE:
+        case DISK_IMAGE_MAP_READ:
+        case DISK_IMAGE_MAP_COW:
+            break;
+        default:
+            return -1;
+    }
+    map_mode = val;
+    fsimage_map_mode_set(val);
     return 0;
 }
 
+static const resource_int_t resources_int[] =
+{
+    { "DiskImageMapping", DISK_IMAGE_MAP_NONE, RES_EVENT_NO, NULL,
+      &map_mode, set_map_mode, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int disk_image_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
 void disk_image_resources_shutdown(void)
 {
 }
 
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-diskimagemapping", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "DiskImageMapping", NULL,
+      "<Mode>", "Access disk images through a memory mapping (0: Off, 1: Read-only, 2: Copy-on-write)" },
+    CMDLINE_LIST_END
+};
+
 int disk_image_cmdline_options_init(void)
 {
-    return 0;
+    return cmdline_register_options(cmdline_options);
 }
 
 /*-----------------------------------------------------------------------*/
 
+/* Write back image changes held in memory for too long, called regularly
+   by the drive code */
+void disk_image_flush_due(void)
+{
+    fsimage_flush_due();
+}
+
 off_t disk_image_size(const disk_image_t *image)
 {
     switch (image->device) {
@@ -28,6 +28,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #include "archdep.h"
 #include "diskconstants.h"
@@ -47,6 +52,24 @@
 
 static log_t fsimage_log = LOG_DEFAULT;
 
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define FSIMAGE_USE_MMAP
+#endif
+
+/* Copy-on-write mappings are written back once this many blocks got dirty */
+#define FSIMAGE_MAP_FLUSH_BLOCKS    64
+
+/* ... or once the oldest unwritten change is this old */
+#define FSIMAGE_MAP_FLUSH_DELAY     TICK_PER_SECOND
+
+/* Mapping mode used for images opened from now on */
+static int fsimage_map_mode = DISK_IMAGE_MAP_NONE;
+
+/* Images with a copy-on-write mapping, for fsimage_flush_due().  Linked by
+   their fsimage_t, as the disk_image_t an image is opened with can be copied
+   afterwards.  */
+static fsimage_t *fsimage_cow_images = NULL;
+
 
 /** \brief  Set image name
  *
@@ -122,6 +145,267 @@ void fsimage_media_destroy(disk_image_t *image)
 
 /*-----------------------------------------------------------------------*/
 
+/** \brief  Set the mapping mode for images opened from now on
+ *
+ * \param[in]   mode    DISK_IMAGE_MAP_NONE, DISK_IMAGE_MAP_READ or
+ *                      DISK_IMAGE_MAP_COW
+ */
+void fsimage_map_mode_set(int mode)
+{
+    fsimage_map_mode = mode;
+}
+
+/** \brief  Map the image file into memory according to the mapping mode
+ *
+ * Failing to map the image is not an error, the stdio stream is used then.
+ *
+ * \param[in,out]   image   disk image
+ */
+static void fsimage_map(disk_image_t *image)
+{
+#ifdef FSIMAGE_USE_MMAP
+    fsimage_t *fsimage = image->media.fsimage;
+    off_t len;
+    void *data;
+    int fd;
+
+    if (fsimage_map_mode == DISK_IMAGE_MAP_NONE
+        || image->type == DISK_IMAGE_TYPE_P64) {
+        return;
+    }
+
+    /* streams kept in memory, like uncompressed gzip images, have no
+       descriptor */
+    fd = fileno(fsimage->fd);
+    len = archdep_file_size(fsimage->fd);
+    if (fd < 0 || len <= 0) {
+        return;
+    }
+
+    if (fsimage_map_mode == DISK_IMAGE_MAP_COW) {
+        data = mmap(NULL, (size_t)len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    } else {
+        data = mmap(NULL, (size_t)len, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    if (data == MAP_FAILED) {
+        log_warning(fsimage_log, "Cannot map `%s', using file access.", fsimage->name);
+        return;
+    }
+
+    fsimage->mapping.data = data;
+    fsimage->mapping.len = (size_t)len;
+    fsimage->mapping.mode = fsimage_map_mode;
+    fsimage->mapping.pending = 0;
+    if (fsimage_map_mode == DISK_IMAGE_MAP_COW) {
+        fsimage->mapping.dirty = lib_calloc((fsimage->mapping.len + FSIMAGE_MAP_BLOCK - 1) / FSIMAGE_MAP_BLOCK, 1);
+        fsimage->mapping.next = fsimage_cow_images;
+        fsimage_cow_images = fsimage;
+    }
+#endif
+}
+
+/** \brief  Write the dirty blocks of a copy-on-write mapping back to the file
+ *
+ * Consecutive dirty blocks are written in one go.  The blocks stay dirty
+ * unless all of them made it to the file, so a failed write back is
+ * retried by the next one.
+ *
+ * \param[in,out]   fsimage file system image
+ *
+ * \return  0 on success, -1 on error
+ */
+static int fsimage_flush_mapping(fsimage_t *fsimage)
+{
+    size_t blocks, start, end, offset, len;
+    int res = 0;
+
+    if (fsimage->mapping.dirty == NULL || fsimage->mapping.pending == 0) {
+        return 0;
+    }
+
+    blocks = (fsimage->mapping.len + FSIMAGE_MAP_BLOCK - 1) / FSIMAGE_MAP_BLOCK;
+    for (start = 0; start < blocks; start = end) {
+        if (!fsimage->mapping.dirty[start]) {
+            end = start + 1;
+            continue;
+        }
+        for (end = start; end < blocks && fsimage->mapping.dirty[end]; end++) {
+        }
+
+        offset = start * FSIMAGE_MAP_BLOCK;
+        len = end * FSIMAGE_MAP_BLOCK;
+        if (len > fsimage->mapping.len) {
+            len = fsimage->mapping.len;
+        }
+        if (util_fpwrite(fsimage->fd, fsimage->mapping.data + offset, len - offset, (long)offset) < 0) {
+            res = -1;
+        }
+    }
+    if (fflush(fsimage->fd) != 0) {
+        res = -1;
+    }
+
+    if (res < 0) {
+        log_error(fsimage_log, "Error writing back `%s'.", fsimage->name);
+        /* try again later instead of on every call */
+        fsimage->mapping.dirty_since = tick_now();
+        return -1;
+    }
+
+    memset(fsimage->mapping.dirty, 0, blocks);
+    fsimage->mapping.pending = 0;
+    return 0;
+}
+
+/** \brief  Write the dirty blocks of a copy-on-write mapping back to the file
+ *
+ * \param[in,out]   image   disk image
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_flush(disk_image_t *image)
+{
+    return fsimage_flush_mapping(image->media.fsimage);
+}
+
+/** \brief  Write back the copy-on-write mappings that held changes for too long
+ *
+ * Called regularly, so changes reach the file even when no more writes
+ * follow them.
+ */
+void fsimage_flush_due(void)
+{
+    fsimage_t *fsimage;
+
+    for (fsimage = fsimage_cow_images; fsimage != NULL; fsimage = fsimage->mapping.next) {
+        if (fsimage->mapping.pending > 0
+            && tick_now_delta(fsimage->mapping.dirty_since) >= FSIMAGE_MAP_FLUSH_DELAY) {
+            fsimage_flush_mapping(fsimage);
+        }
+    }
+}
+
+/** \brief  Write back and drop the mapping of the image, if any
+ *
+ * Needed before the stdio stream is used directly.
+ *
+ * \param[in,out]   image   disk image
+ */
+void fsimage_unmap(disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+
+    if (fsimage->mapping.data == NULL) {
+        return;
+    }
+
+    fsimage_flush(image);
+    if (fsimage->mapping.dirty != NULL) {
+        fsimage_t **prev = &fsimage_cow_images;
+
+        while (*prev != fsimage) {
+            prev = &(*prev)->mapping.next;
+        }
+        *prev = fsimage->mapping.next;
+    }
+#ifdef FSIMAGE_USE_MMAP
+    munmap(fsimage->mapping.data, fsimage->mapping.len);
+#endif
+    lib_free(fsimage->mapping.dirty);
+    memset(&fsimage->mapping, 0, sizeof(fsimage->mapping));
+}
+
+/** \brief  Read bytes at a position of the image
+ *
+ * Served from the mapping if there is one, data beyond it (the image may
+ * have grown since it was mapped) comes from the file.
+ *
+ * \param[in]   image   disk image
+ * \param[out]  buf     buffer
+ * \param[in]   num     number of bytes
+ * \param[in]   offset  offset in the image
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_pread(const disk_image_t *image, void *buf, size_t num, long offset)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    size_t n;
+
+    if (fsimage->mapping.data != NULL && offset >= 0
+        && (size_t)offset < fsimage->mapping.len) {
+        n = fsimage->mapping.len - (size_t)offset;
+        if (n > num) {
+            n = num;
+        }
+        memcpy(buf, fsimage->mapping.data + offset, n);
+        if (n == num) {
+            return 0;
+        }
+        buf = (uint8_t *)buf + n;
+        num -= n;
+        offset += (long)n;
+    }
+
+    return util_fpread(fsimage->fd, buf, num, offset);
+}
+
+/** \brief  Write bytes at a position of the image
+ *
+ * With a copy-on-write mapping the data only goes to the mapping and the
+ * blocks are marked dirty, to be written back by fsimage_flush().  Otherwise
+ * the data is written to the file.
+ *
+ * \param[in,out]  image   disk image
+ * \param[in]      buf     data
+ * \param[in]      num     number of bytes
+ * \param[in]      offset  offset in the image
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_pwrite(disk_image_t *image, const void *buf, size_t num, long offset)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    size_t n, block;
+
+    if (fsimage->mapping.dirty != NULL && num > 0 && offset >= 0
+        && (size_t)offset < fsimage->mapping.len) {
+        n = fsimage->mapping.len - (size_t)offset;
+        if (n > num) {
+            n = num;
+        }
+        memcpy(fsimage->mapping.data + offset, buf, n);
+        for (block = (size_t)offset / FSIMAGE_MAP_BLOCK;
+             block <= ((size_t)offset + n - 1) / FSIMAGE_MAP_BLOCK; block++) {
+            if (!fsimage->mapping.dirty[block]) {
+                if (fsimage->mapping.pending == 0) {
+                    fsimage->mapping.dirty_since = tick_now();
+                }
+                fsimage->mapping.dirty[block] = 1;
+                fsimage->mapping.pending++;
+            }
+        }
+        if (n == num) {
+            if (fsimage->mapping.pending >= FSIMAGE_MAP_FLUSH_BLOCKS) {
+                return fsimage_flush(image);
+            }
+            return 0;
+        }
+        buf = (const uint8_t *)buf + n;
+        num -= n;
+        offset += (long)n;
+    }
+
+    if (util_fpwrite(fsimage->fd, buf, num, offset) < 0) {
+        return -1;
+    }
+    if (fsimage->mapping.data != NULL) {
+        /* make the data visible through the mapping */
+        fflush(fsimage->fd);
+    }
+    return 0;
+}
+
 int fsimage_open(disk_image_t *image)
 {
     fsimage_t *fsimage;
@@ -162,6 +446,7 @@ int fsimage_open(disk_image_t *image)
     }
 
     if (fsimage_probe(image) == 0) {
+        fsimage_map(image);
         return 0;
     }
 
@@ -190,6 +475,7 @@ int fsimage_close(disk_image_t *image)
         lib_free(fsimage->error_info.map);
         fsimage->error_info.map = NULL;
     }
+    fsimage_unmap(image);
     zfile_fclose(fsimage->fd);
     fsimage->fd = NULL;
 
@@ -29,6 +29,7 @@
 
 #include <stdio.h>
 
+#include "archdep_tick.h"
 #include "types.h"
 
 struct disk_image_s;
@@ -42,8 +43,20 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    struct {
+        uint8_t *data;          /* mapped image, NULL if not mapped */
+        size_t len;
+        int mode;               /* DISK_IMAGE_MAP_READ or DISK_IMAGE_MAP_COW */
+        uint8_t *dirty;         /* one flag per FSIMAGE_MAP_BLOCK bytes */
+        unsigned int pending;   /* blocks dirtied since the last flush */
+        tick_t dirty_since;     /* when the oldest pending block got dirty */
+        struct fsimage_s *next; /* next image with a copy-on-write mapping */
+    } mapping;
 } fsimage_t;
 
+/* Granularity of the dirty tracking of copy-on-write mappings */
+#define FSIMAGE_MAP_BLOCK   4096
+
 
 void fsimage_init(void);
 
@@ -61,4 +74,11 @@ int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
                          const struct disk_addr_s *dadr);
 off_t fsimage_size(const disk_image_t *image);
 
+void fsimage_map_mode_set(int mode);
+int fsimage_pread(const struct disk_image_s *image, void *buf, size_t num, long offset);
+int fsimage_pwrite(struct disk_image_s *image, const void *buf, size_t num, long offset);
+int fsimage_flush(struct disk_image_s *image);
+void fsimage_flush_due(void);
+void fsimage_unmap(struct disk_image_s *image);
+
 #endif
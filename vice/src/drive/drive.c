@@ -561,6 +561,12 @@ monitor_interface_t *drive_cpu_monitor_interface_get(unsigned int dnr)
     return diskunit_context[dnr]->cpu->monitor_interface;
 }
 
+/* Number of drive cycles skipped while the drive was idling.  */
+CLOCK drive_cpu_get_idle_skipped_cycles(unsigned int dnr)
+{
+    return diskunit_context[dnr]->cpu->idle_skipped_cycles;
+}
+
 void drive_cpu_early_init_all(void)
 {
     unsigned int dnr;
@@ -1023,6 +1029,7 @@ void drive_vsync_hook(void)
     unsigned int dnr;
 
     drive_update_ui_status();
+    disk_image_flush_due();
 
     for (dnr = 0; dnr < NUM_DISK_UNITS; dnr++) {
         diskunit_context_t *unit = diskunit_context[dnr];
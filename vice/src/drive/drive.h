@@ -365,6 +365,7 @@ void drive_move_head(int step, struct drive_s *drive);
 
 /* Don't use these pointers before the context is set up!  */
 struct monitor_interface_s *drive_cpu_monitor_interface_get(unsigned int dnr);
+CLOCK drive_cpu_get_idle_skipped_cycles(unsigned int dnr);
 
 void drive_cpu_early_init_all(void);
 void drive_cpu_trigger_reset(unsigned int dnr);
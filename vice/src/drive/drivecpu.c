@@ -280,6 +280,9 @@ inline static uint32_t drive_trap_handler(diskunit_context_t *drv)
                 next_clk = drv->cpu->stop_clk;
             }
 
+            if (next_clk > *(drv->clk_ptr)) {
+                drv->cpu->idle_skipped_cycles += next_clk - *(drv->clk_ptr);
+            }
             *(drv->clk_ptr) = next_clk;
         }
         return 0;
@@ -82,6 +82,9 @@ typedef struct drivecpu_context_s {
 
     CLOCK stop_clk;
 
+    /* Number of drive cycles skipped by the `trap idle' method.  */
+    CLOCK idle_skipped_cycles;
+
     CLOCK cycle_accum;
     uint8_t *d_bank_base;
     unsigned int d_bank_start;
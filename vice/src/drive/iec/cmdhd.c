@@ -1366,7 +1366,8 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
         return -1;
     }
 
-    /* copy file FD to the scsi module */
+    /* copy file FD to the scsi module, which accesses the file directly */
+    fsimage_unmap(image);
     hd->scsi->file[0] = image->media.fsimage->fd;
 
     /* find the base lba */
@@ -197,7 +197,9 @@ void rotation_table_set(uint32_t *rotation_table_ptr)
         rotation[dnr].rotation_last_clk = drive->snap_rotation_last_clk;
         rotation[dnr].last_read_data = drive->snap_last_read_data;
         rotation[dnr].last_write_data = drive->snap_last_write_data;
-        rotation[dnr].bit_counter = drive->snap_bit_counter;
+        /* the rotation code counts 0..7 and relies on it, don't trust the
+           snapshot */
+        rotation[dnr].bit_counter = drive->snap_bit_counter & 7;
         rotation[dnr].zero_count = drive->snap_zero_count;
         rotation[dnr].seed = drive->snap_seed;
         rotation[dnr].speed_zone = drive->snap_speed_zone;
@@ -277,6 +279,70 @@ inline static int read_next_bit(drive_t *dptr)
     return (dptr->GCR_track_start_ptr[byte_offset] >> bit) & 1;
 }
 
+/* Fetch `count' (1...32) bits of the track starting at bit offset `off', the
+   first one ending up in the most significant position.  The bits must not
+   run past the end of the track.  */
+inline static uint32_t read_track_bits(const uint8_t *track, unsigned int off, unsigned int count)
+{
+    const uint8_t *p = track + (off >> 3);
+    unsigned int bytes = ((off & 7) + count + 7) >> 3;
+    uint64_t bits = 0;
+    unsigned int i;
+
+    for (i = 0; i < bytes; i++) {
+        bits = (bits << 8) | p[i];
+    }
+    bits >>= (bytes << 3) - (off & 7) - count;
+
+    return (uint32_t)(bits & (((uint64_t)1 << count) - 1));
+}
+
+/* Store the low `count' (1...8) bits of `value' at the head position, the most
+   significant one first; same semantics as calling write_next_bit() for each
+   of them.  */
+inline static void write_track_bits(drive_t *dptr, unsigned int value, unsigned int count)
+{
+    unsigned int track_bits = dptr->GCR_current_track_size << 3;
+    unsigned int off = dptr->GCR_head_offset;
+    unsigned int n, shift, mask;
+    uint8_t *p;
+
+    /* if no image is attached, writes do nothing */
+    if (dptr->GCR_image_loaded == 0) {
+        return;
+    }
+
+    if (off >= track_bits) {
+        while (count--) {
+            write_next_bit(dptr, (value >> count) & 1);
+        }
+        return;
+    }
+
+    while (count > 0) {
+        /* bits up to the next byte boundary */
+        n = 8 - (off & 7);
+        if (n > count) {
+            n = count;
+        }
+        count -= n;
+
+        if (dptr->GCR_track_start_ptr != NULL) {
+            p = dptr->GCR_track_start_ptr + (off >> 3);
+            shift = 8 - (off & 7) - n;
+            mask = ((1 << n) - 1) << shift;
+            *p = (uint8_t)((*p & ~mask) | (((value >> count) << shift) & mask));
+            dptr->GCR_dirty_track = 1;
+        }
+
+        off += n;
+        if (off >= track_bits) {
+            off = 0;
+        }
+    }
+    dptr->GCR_head_offset = off;
+}
+
 inline static int32_t RANDOM_nextInt(rotation_t *rptr)
 {
     uint32_t bits = rptr->seed >> 15;
@@ -982,6 +1048,157 @@ static void rotation_1541_p64_cycle(drive_t *dptr)
     }
 }
 
+/* Read `bits_moved' bits from the track one at a time; used when there is no
+   track data to fetch words from.  */
+static void rotation_1541_simple_read_bits(drive_t *dptr, rotation_t *rptr, int bits_moved)
+{
+    int off = dptr->GCR_head_offset;
+    unsigned int byte, last_read_data = rptr->last_read_data << 7;
+    unsigned int bit_counter = rptr->bit_counter;
+
+    /* if no image is attached or track does not exists, read 0 */
+    if (dptr->GCR_image_loaded == 0 || dptr->GCR_track_start_ptr == NULL) {
+        byte = 0;
+    } else {
+        byte = dptr->GCR_track_start_ptr[off >> 3] << (off & 7);
+    }
+
+    while (bits_moved-- != 0) {
+        byte <<= 1; off++;
+        if (!(off & 7)) {
+            if ((off >> 3) >= (int)dptr->GCR_current_track_size) {
+                off = 0;
+            }
+            /* if no image is attached or track does not exists, read 0 */
+            if (dptr->GCR_image_loaded == 0 || dptr->GCR_track_start_ptr == NULL) {
+                byte = 0;
+            } else {
+                byte = dptr->GCR_track_start_ptr[off >> 3];
+            }
+        }
+
+        last_read_data <<= 1;
+        last_read_data |= byte & 0x80;
+        rptr->last_write_data <<= 1;
+
+        /* is sync? reset bit counter, don't move data, etc. */
+        if (~last_read_data & 0x1ff80) {
+            if (++bit_counter == 8) {
+                bit_counter = 0;
+                dptr->GCR_read = (uint8_t) (last_read_data >> 7);
+                /* tlr claims that the write register is loaded at every
+                 * byte boundary, and since the bus is shared, it's reasonable
+                 * to guess that it would be loaded with whatever was last read. */
+                rptr->last_write_data = dptr->GCR_read;
+                if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
+                    dptr->byte_ready_edge = 1;
+                    dptr->byte_ready_level = 1;
+                }
+            }
+        } else {
+            bit_counter = 0;
+        }
+    }
+    rptr->last_read_data = (last_read_data >> 7) & 0x3ff;
+    rptr->bit_counter = bit_counter;
+    dptr->GCR_head_offset = off;
+}
+
+/* Read `bits_moved' bits from the track up to 32 at a time.  Sync marks and
+   byte boundaries are located on the whole word at once; only a word where a
+   sync ends less than 8 bits before its end is stepped through bit by bit to
+   find the last byte completed before the sync.  */
+static void rotation_1541_simple_read(drive_t *dptr, rotation_t *rptr, int bits_moved)
+{
+    unsigned int off = dptr->GCR_head_offset;
+    unsigned int track_bits = dptr->GCR_current_track_size << 3;
+    const uint8_t *track = dptr->GCR_track_start_ptr;
+    unsigned int pos, bit_counter = rptr->bit_counter;
+    unsigned int last_write_data = rptr->last_write_data;
+    unsigned int count, age;
+    uint64_t window = rptr->last_read_data;
+    uint64_t ones2, ones4, sync;
+
+    if (dptr->GCR_image_loaded == 0 || track == NULL || off >= track_bits) {
+        rotation_1541_simple_read_bits(dptr, rptr, bits_moved);
+        return;
+    }
+
+    /* the bit under the head has been read already, continue with the next */
+    pos = off + 1;
+    if (pos >= track_bits) {
+        pos = 0;
+    }
+
+    while (bits_moved > 0) {
+        count = bits_moved > 32 ? 32 : (unsigned int)bits_moved;
+        if (count > track_bits - pos) {
+            count = track_bits - pos;
+        }
+        bits_moved -= count;
+
+        /* bit 0 of the window is the bit read last */
+        window = (window << count) | read_track_bits(track, pos, count);
+        off = pos + count - 1;
+        pos += count;
+        if (pos >= track_bits) {
+            pos = 0;
+        }
+
+        /* bit n of `sync' is set if the 10 bits read just before the last n
+           ones were all 1 */
+        ones2 = window & (window >> 1);
+        ones4 = ones2 & (ones2 >> 2);
+        sync = ones4 & (ones4 >> 4) & (ones2 >> 8) & (((uint64_t)1 << count) - 1);
+
+        if (sync != 0) {
+            for (age = 0; (sync & 1) == 0; age++) {
+                sync >>= 1;
+            }
+            if (age < 8) {
+                /* no byte completed after the last sync, step through the bits */
+                while (count-- != 0) {
+                    last_write_data <<= 1;
+                    if (((window >> count) & 0x3ff) == 0x3ff) {
+                        bit_counter = 0;
+                    } else if (++bit_counter == 8) {
+                        bit_counter = 0;
+                        dptr->GCR_read = (uint8_t)(window >> count);
+                        last_write_data = dptr->GCR_read;
+                        if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
+                            dptr->byte_ready_edge = 1;
+                            dptr->byte_ready_level = 1;
+                        }
+                    }
+                }
+                continue;
+            }
+            /* the bit counter restarts at the last sync */
+            bit_counter = 0;
+            count = age;
+        }
+
+        bit_counter += count;
+        if (bit_counter >= 8) {
+            /* only the last byte completed is visible */
+            bit_counter &= 7;
+            dptr->GCR_read = (uint8_t)(window >> bit_counter);
+            /* the write register is loaded at every byte boundary too */
+            last_write_data = (unsigned int)dptr->GCR_read << bit_counter;
+            if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
+                dptr->byte_ready_edge = 1;
+                dptr->byte_ready_level = 1;
+            }
+        } else {
+            last_write_data <<= count;
+        }
+    }
+    rptr->last_read_data = (unsigned int)(window & 0x3ff);
+    rptr->last_write_data = (uint8_t)last_write_data;
+    rptr->bit_counter = bit_counter;
+    dptr->GCR_head_offset = off;
+}
+
 /*******************************************************************************
  * very simple and fast emulation for perfect images like those coming from
  * dxx files
@@ -1019,56 +1236,7 @@ static void rotation_1541_simple(drive_t *dptr)
     }
 
     if (dptr->read_write_mode) {
-        int off = dptr->GCR_head_offset;
-        unsigned int byte, last_read_data = rptr->last_read_data << 7;
-        unsigned int bit_counter = rptr->bit_counter;
-
-        /* if no image is attached or track does not exists, read 0 */
-        if (dptr->GCR_image_loaded == 0 || dptr->GCR_track_start_ptr == NULL) {
-            byte = 0;
-        } else {
-            byte = dptr->GCR_track_start_ptr[off >> 3] << (off & 7);
-        }
-
-        while (bits_moved-- != 0) {
-            byte <<= 1; off++;
-            if (!(off & 7)) {
-                if ((off >> 3) >= (int)dptr->GCR_current_track_size) {
-                    off = 0;
-                }
-                /* if no image is attached or track does not exists, read 0 */
-                if (dptr->GCR_image_loaded == 0 || dptr->GCR_track_start_ptr == NULL) {
-                    byte = 0;
-                } else {
-                    byte = dptr->GCR_track_start_ptr[off >> 3];
-                }
-            }
-
-            last_read_data <<= 1;
-            last_read_data |= byte & 0x80;
-            rptr->last_write_data <<= 1;
-
-            /* is sync? reset bit counter, don't move data, etc. */
-            if (~last_read_data & 0x1ff80) {
-                if (++bit_counter == 8) {
-                    bit_counter = 0;
-                    dptr->GCR_read = (uint8_t) (last_read_data >> 7);
-                    /* tlr claims that the write register is loaded at every
-                     * byte boundary, and since the bus is shared, it's reasonable
-                     * to guess that it would be loaded with whatever was last read. */
-                    rptr->last_write_data = dptr->GCR_read;
-                    if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
-                        dptr->byte_ready_edge = 1;
-                        dptr->byte_ready_level = 1;
-                    }
-                }
-            } else {
-                bit_counter = 0;
-            }
-        }
-        rptr->last_read_data = (last_read_data >> 7) & 0x3ff;
-        rptr->bit_counter = bit_counter;
-        dptr->GCR_head_offset = off;
+        rotation_1541_simple_read(dptr, rptr, bits_moved);
         if (!dptr->GCR_read) {    /* can only happen if on a half or unformatted track */
             dptr->GCR_read = 0x11; /* should be good enough, there's no data after all */
         }
@@ -1076,16 +1244,28 @@ static void rotation_1541_simple(drive_t *dptr)
         /* When writing, the first byte after transition is going to echo the
          * bits from the last read value.
          */
-        while (bits_moved-- != 0) {
-            rptr->last_read_data = (rptr->last_read_data << 1) & 0x3fe;
-            if ((rptr->last_read_data & 0xf) == 0) {
-                rptr->last_read_data |= 1;
+        while (bits_moved != 0) {
+            /* write the bits up to the next reload of the write register at once */
+            int count = 8 - rptr->bit_counter;
+            int i;
+
+            if (count > bits_moved) {
+                count = bits_moved;
+            }
+            bits_moved -= count;
+
+            for (i = 0; i < count; i++) {
+                rptr->last_read_data = (rptr->last_read_data << 1) & 0x3fe;
+                if ((rptr->last_read_data & 0xf) == 0) {
+                    rptr->last_read_data |= 1;
+                }
             }
 
-            write_next_bit(dptr, rptr->last_write_data & 0x80);
-            rptr->last_write_data <<= 1;
+            write_track_bits(dptr, rptr->last_write_data >> (8 - count), count);
+            rptr->last_write_data <<= count;
 
-            if (++rptr->bit_counter == 8) {
+            rptr->bit_counter += count;
+            if (rptr->bit_counter == 8) {
                 rptr->bit_counter = 0;
                 rptr->last_write_data = dptr->GCR_write_value;
                 if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
@@ -48,65 +48,145 @@
 #include "cbmdos.h"
 #include "diskimage.h"
 
-static const uint8_t GCR_conv_data[16] =
+/* GCR code of every byte, the upper nybble in bits 5...9 and the lower one in
+   bits 0...4 */
+static const uint16_t GCR_conv_data[256] =
 {
-    0x0a, 0x0b, 0x12, 0x13,
-    0x0e, 0x0f, 0x16, 0x17,
-    0x09, 0x19, 0x1a, 0x1b,
-    0x0d, 0x1d, 0x1e, 0x15
+    0x14a, 0x14b, 0x152, 0x153, 0x14e, 0x14f, 0x156, 0x157,
+    0x149, 0x159, 0x15a, 0x15b, 0x14d, 0x15d, 0x15e, 0x155,
+    0x16a, 0x16b, 0x172, 0x173, 0x16e, 0x16f, 0x176, 0x177,
+    0x169, 0x179, 0x17a, 0x17b, 0x16d, 0x17d, 0x17e, 0x175,
+    0x24a, 0x24b, 0x252, 0x253, 0x24e, 0x24f, 0x256, 0x257,
+    0x249, 0x259, 0x25a, 0x25b, 0x24d, 0x25d, 0x25e, 0x255,
+    0x26a, 0x26b, 0x272, 0x273, 0x26e, 0x26f, 0x276, 0x277,
+    0x269, 0x279, 0x27a, 0x27b, 0x26d, 0x27d, 0x27e, 0x275,
+    0x1ca, 0x1cb, 0x1d2, 0x1d3, 0x1ce, 0x1cf, 0x1d6, 0x1d7,
+    0x1c9, 0x1d9, 0x1da, 0x1db, 0x1cd, 0x1dd, 0x1de, 0x1d5,
+    0x1ea, 0x1eb, 0x1f2, 0x1f3, 0x1ee, 0x1ef, 0x1f6, 0x1f7,
+    0x1e9, 0x1f9, 0x1fa, 0x1fb, 0x1ed, 0x1fd, 0x1fe, 0x1f5,
+    0x2ca, 0x2cb, 0x2d2, 0x2d3, 0x2ce, 0x2cf, 0x2d6, 0x2d7,
+    0x2c9, 0x2d9, 0x2da, 0x2db, 0x2cd, 0x2dd, 0x2de, 0x2d5,
+    0x2ea, 0x2eb, 0x2f2, 0x2f3, 0x2ee, 0x2ef, 0x2f6, 0x2f7,
+    0x2e9, 0x2f9, 0x2fa, 0x2fb, 0x2ed, 0x2fd, 0x2fe, 0x2f5,
+    0x12a, 0x12b, 0x132, 0x133, 0x12e, 0x12f, 0x136, 0x137,
+    0x129, 0x139, 0x13a, 0x13b, 0x12d, 0x13d, 0x13e, 0x135,
+    0x32a, 0x32b, 0x332, 0x333, 0x32e, 0x32f, 0x336, 0x337,
+    0x329, 0x339, 0x33a, 0x33b, 0x32d, 0x33d, 0x33e, 0x335,
+    0x34a, 0x34b, 0x352, 0x353, 0x34e, 0x34f, 0x356, 0x357,
+    0x349, 0x359, 0x35a, 0x35b, 0x34d, 0x35d, 0x35e, 0x355,
+    0x36a, 0x36b, 0x372, 0x373, 0x36e, 0x36f, 0x376, 0x377,
+    0x369, 0x379, 0x37a, 0x37b, 0x36d, 0x37d, 0x37e, 0x375,
+    0x1aa, 0x1ab, 0x1b2, 0x1b3, 0x1ae, 0x1af, 0x1b6, 0x1b7,
+    0x1a9, 0x1b9, 0x1ba, 0x1bb, 0x1ad, 0x1bd, 0x1be, 0x1b5,
+    0x3aa, 0x3ab, 0x3b2, 0x3b3, 0x3ae, 0x3af, 0x3b6, 0x3b7,
+    0x3a9, 0x3b9, 0x3ba, 0x3bb, 0x3ad, 0x3bd, 0x3be, 0x3b5,
+    0x3ca, 0x3cb, 0x3d2, 0x3d3, 0x3ce, 0x3cf, 0x3d6, 0x3d7,
+    0x3c9, 0x3d9, 0x3da, 0x3db, 0x3cd, 0x3dd, 0x3de, 0x3d5,
+    0x2aa, 0x2ab, 0x2b2, 0x2b3, 0x2ae, 0x2af, 0x2b6, 0x2b7,
+    0x2a9, 0x2b9, 0x2ba, 0x2bb, 0x2ad, 0x2bd, 0x2be, 0x2b5
 };
 
-static const uint8_t From_GCR_conv_data[32] =
+/* Byte value of every 10 bit GCR code; invalid 5 bit codes give 0 for the
+   respective nybble */
+static const uint8_t From_GCR_conv_data[1024] =
 {
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 8, 0, 1, 0, 12, 4, 5,
-    0, 0, 2, 3, 0, 15, 6, 7,
-    0, 9, 10, 11, 0, 13, 14, 0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x88, 0x80, 0x81, 0x80, 0x8c, 0x84, 0x85,
+    0x80, 0x80, 0x82, 0x83, 0x80, 0x8f, 0x86, 0x87, 0x80, 0x89, 0x8a, 0x8b, 0x80, 0x8d, 0x8e, 0x80,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x18, 0x10, 0x11, 0x10, 0x1c, 0x14, 0x15,
+    0x10, 0x10, 0x12, 0x13, 0x10, 0x1f, 0x16, 0x17, 0x10, 0x19, 0x1a, 0x1b, 0x10, 0x1d, 0x1e, 0x10,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc8, 0xc0, 0xc1, 0xc0, 0xcc, 0xc4, 0xc5,
+    0xc0, 0xc0, 0xc2, 0xc3, 0xc0, 0xcf, 0xc6, 0xc7, 0xc0, 0xc9, 0xca, 0xcb, 0xc0, 0xcd, 0xce, 0xc0,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x48, 0x40, 0x41, 0x40, 0x4c, 0x44, 0x45,
+    0x40, 0x40, 0x42, 0x43, 0x40, 0x4f, 0x46, 0x47, 0x40, 0x49, 0x4a, 0x4b, 0x40, 0x4d, 0x4e, 0x40,
+    0x50, 0x50, 0x50, 0x50, 0x50, 0x50, 0x50, 0x50, 0x50, 0x58, 0x50, 0x51, 0x50, 0x5c, 0x54, 0x55,
+    0x50, 0x50, 0x52, 0x53, 0x50, 0x5f, 0x56, 0x57, 0x50, 0x59, 0x5a, 0x5b, 0x50, 0x5d, 0x5e, 0x50,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x28, 0x20, 0x21, 0x20, 0x2c, 0x24, 0x25,
+    0x20, 0x20, 0x22, 0x23, 0x20, 0x2f, 0x26, 0x27, 0x20, 0x29, 0x2a, 0x2b, 0x20, 0x2d, 0x2e, 0x20,
+    0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x38, 0x30, 0x31, 0x30, 0x3c, 0x34, 0x35,
+    0x30, 0x30, 0x32, 0x33, 0x30, 0x3f, 0x36, 0x37, 0x30, 0x39, 0x3a, 0x3b, 0x30, 0x3d, 0x3e, 0x30,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf8, 0xf0, 0xf1, 0xf0, 0xfc, 0xf4, 0xf5,
+    0xf0, 0xf0, 0xf2, 0xf3, 0xf0, 0xff, 0xf6, 0xf7, 0xf0, 0xf9, 0xfa, 0xfb, 0xf0, 0xfd, 0xfe, 0xf0,
+    0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x68, 0x60, 0x61, 0x60, 0x6c, 0x64, 0x65,
+    0x60, 0x60, 0x62, 0x63, 0x60, 0x6f, 0x66, 0x67, 0x60, 0x69, 0x6a, 0x6b, 0x60, 0x6d, 0x6e, 0x60,
+    0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x78, 0x70, 0x71, 0x70, 0x7c, 0x74, 0x75,
+    0x70, 0x70, 0x72, 0x73, 0x70, 0x7f, 0x76, 0x77, 0x70, 0x79, 0x7a, 0x7b, 0x70, 0x7d, 0x7e, 0x70,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x98, 0x90, 0x91, 0x90, 0x9c, 0x94, 0x95,
+    0x90, 0x90, 0x92, 0x93, 0x90, 0x9f, 0x96, 0x97, 0x90, 0x99, 0x9a, 0x9b, 0x90, 0x9d, 0x9e, 0x90,
+    0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa8, 0xa0, 0xa1, 0xa0, 0xac, 0xa4, 0xa5,
+    0xa0, 0xa0, 0xa2, 0xa3, 0xa0, 0xaf, 0xa6, 0xa7, 0xa0, 0xa9, 0xaa, 0xab, 0xa0, 0xad, 0xae, 0xa0,
+    0xb0, 0xb0, 0xb0, 0xb0, 0xb0, 0xb0, 0xb0, 0xb0, 0xb0, 0xb8, 0xb0, 0xb1, 0xb0, 0xbc, 0xb4, 0xb5,
+    0xb0, 0xb0, 0xb2, 0xb3, 0xb0, 0xbf, 0xb6, 0xb7, 0xb0, 0xb9, 0xba, 0xbb, 0xb0, 0xbd, 0xbe, 0xb0,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00,
+    0xd0, 0xd0, 0xd0, 0xd0, 0xd0, 0xd0, 0xd0, 0xd0, 0xd0, 0xd8, 0xd0, 0xd1, 0xd0, 0xdc, 0xd4, 0xd5,
+    0xd0, 0xd0, 0xd2, 0xd3, 0xd0, 0xdf, 0xd6, 0xd7, 0xd0, 0xd9, 0xda, 0xdb, 0xd0, 0xdd, 0xde, 0xd0,
+    0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe0, 0xe8, 0xe0, 0xe1, 0xe0, 0xec, 0xe4, 0xe5,
+    0xe0, 0xe0, 0xe2, 0xe3, 0xe0, 0xef, 0xe6, 0xe7, 0xe0, 0xe9, 0xea, 0xeb, 0xe0, 0xed, 0xee, 0xe0,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x04, 0x05,
+    0x00, 0x00, 0x02, 0x03, 0x00, 0x0f, 0x06, 0x07, 0x00, 0x09, 0x0a, 0x0b, 0x00, 0x0d, 0x0e, 0x00
 };
 
 
 static void gcr_convert_4bytes_to_GCR(const uint8_t *source, uint8_t *dest)
 {
-    int i;
-    register unsigned int tdest = 0;    /* at least 16 bits for overflow shifting */
-
-    for (i = 2; i < 10; i += 2, source++, dest++)
-    {
-        tdest <<= 5;  /* make room for the upper nybble */
-        tdest |= GCR_conv_data[(*source) >> 4];
-
-        tdest <<= 5;  /* make room for the lower nybble */
-        tdest |= GCR_conv_data[(*source) & 0x0f];
-
-        *dest = (uint8_t)(tdest >> i);
-    }
+    uint64_t tdest = ((uint64_t)GCR_conv_data[source[0]] << 30)
+                     | ((uint64_t)GCR_conv_data[source[1]] << 20)
+                     | ((uint64_t)GCR_conv_data[source[2]] << 10)
+                     | GCR_conv_data[source[3]];
+
+    dest[0] = (uint8_t)(tdest >> 32);
+    dest[1] = (uint8_t)(tdest >> 24);
+    dest[2] = (uint8_t)(tdest >> 16);
+    dest[3] = (uint8_t)(tdest >> 8);
+    dest[4] = (uint8_t)tdest;
+}
 
-    *dest = (uint8_t)tdest;
+/* Decode the 40 GCR bits in the low bits of `source' into 4 bytes */
+static void gcr_convert_GCR40_to_4bytes(uint64_t source, uint8_t *dest)
+{
+    dest[0] = From_GCR_conv_data[(source >> 30) & 0x3ff];
+    dest[1] = From_GCR_conv_data[(source >> 20) & 0x3ff];
+    dest[2] = From_GCR_conv_data[(source >> 10) & 0x3ff];
+    dest[3] = From_GCR_conv_data[source & 0x3ff];
 }
 
 static void gcr_convert_GCR_to_4bytes(const uint8_t *source, uint8_t *dest)
 {
-    int i;
-    /* at least 24 bits for shifting into bits 16...20 */
-    register uint32_t tdest = *source;
-
-    tdest <<= 13;
-
-    for (i = 5; i < 13; i += 2, dest++)
-    {
-        source++;
-        tdest |= ((uint32_t)(*source)) << i;
-
-        /*  "tdest >> 16" could be optimized to a word
-         *  aligned access, hopefully the compiler does
-         *  this for us (in a portable way)
-         */
-        *dest = From_GCR_conv_data[(tdest >> 16) & 0x1f] << 4;
-        tdest <<= 5;
-
-        *dest |= From_GCR_conv_data[(tdest >> 16) & 0x1f];
-        tdest <<= 5;
-    }
+    gcr_convert_GCR40_to_4bytes(((uint64_t)source[0] << 32)
+                                | ((uint32_t)source[1] << 24)
+                                | ((uint32_t)source[2] << 16)
+                                | ((uint32_t)source[3] << 8)
+                                | source[4], dest);
 }
 
 void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *data, const gcr_header_t *header,
@@ -167,36 +247,64 @@ void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *data, const gcr_h
     gcr_convert_4bytes_to_GCR(buf, data);
 }
 
+/* Fetch `count' (1...32) bits of the track starting at bit `p', the first one
+   ending up in the most significant position.  The bits must not run past the
+   end of the track.  */
+static uint32_t gcr_get_bits(const uint8_t *data, int p, int count)
+{
+    const uint8_t *q = data + (p >> 3);
+    int i, bytes = ((p & 7) + count + 7) >> 3;
+    uint64_t bits = 0;
+
+    for (i = 0; i < bytes; i++) {
+        bits = (bits << 8) | q[i];
+    }
+    bits >>= (bytes << 3) - (p & 7) - count;
+
+    return (uint32_t)(bits & (((uint64_t)1 << count) - 1));
+}
+
+/* Scan `s' bits from bit `p' on for a sync and return the position of the first
+   0 bit after at least 10 1 bits.  The track is scanned up to 32 bits at a
+   time.  */
 static int gcr_find_sync(const disk_track_t *raw, int p, int s)
 {
-    unsigned int w;
-    int b;
+    int count, age, track_bits;
+    uint64_t window, ones, ones2, ones4, sync;
 
     if (!raw->data || !raw->size) {
         return -CBMDOS_FDC_ERR_SYNC;
     }
 
-    w = 0;
-    b = raw->data[p >> 3] << (p & 7);
-    while (s--) {
-        if (b & 0x80) {
-            w = (w << 1) | 1;
-        } else {
-            if (~w & 0x3ff) {
-                w <<= 1;
-            } else {
-                return p;
-            }
+    track_bits = raw->size * 8;
+
+    /* bit 0 of the window is the bit scanned last */
+    window = 0;
+    while (s > 0) {
+        count = s > 32 ? 32 : s;
+        if (count > track_bits - p) {
+            count = track_bits - p;
         }
-        if (~p & 7) {
-            p++;
-            b <<= 1;
-        } else {
-            p++;
-            if (p >= raw->size * 8) {
-                p = 0;
+        window = (window << count) | gcr_get_bits(raw->data, p, count);
+
+        /* bit n of `sync' is set if the bit scanned n bits before the last
+           one is a 0 following 10 1 bits */
+        ones = window >> 1;
+        ones2 = ones & (ones >> 1);
+        ones4 = ones2 & (ones2 >> 2);
+        sync = ones4 & (ones4 >> 4) & (ones2 >> 8) & ~window & (((uint64_t)1 << count) - 1);
+
+        if (sync != 0) {
+            /* the earliest sync is the highest bit */
+            for (age = count - 1; ((sync >> age) & 1) == 0; age--) {
             }
-            b = raw->data[p >> 3];
+            return p + count - 1 - age;
+        }
+
+        s -= count;
+        p += count;
+        if (p >= track_bits) {
+            p = 0;
         }
     }
     return -CBMDOS_FDC_ERR_SYNC;
@@ -211,6 +319,21 @@ static void gcr_decode_block(const disk_track_t *raw, int p, uint8_t *buf, int n
     shift = p & 7;
     offset = raw->data + (p >> 3);
 
+    if ((p >> 3) + num * 5 < raw->size) {
+        /* no wraparound: take the 40 bits of each group from 6 bytes at once */
+        for (i = 0; i < num; i++, offset += 5, buf += 4) {
+            uint64_t bits = ((uint64_t)offset[0] << 40)
+                            | ((uint64_t)offset[1] << 32)
+                            | ((uint32_t)offset[2] << 24)
+                            | ((uint32_t)offset[3] << 16)
+                            | ((uint32_t)offset[4] << 8)
+                            | offset[5];
+
+            gcr_convert_GCR40_to_4bytes(bits >> (8 - shift), buf);
+        }
+        return;
+    }
+
     b = offset[0] << shift;
     for (i = 0; i < num; i++, buf += 4) {
         /* get 5 bytes of gcr data */
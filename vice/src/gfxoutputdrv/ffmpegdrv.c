@@ -40,6 +40,7 @@
 #include "cmdline.h"
 #include "ffmpegdrv.h"
 #include "ffmpeglib.h"
+#include "ffmpegqueue.h"
 #include "gfxoutput.h"
 #include "lib.h"
 #include "log.h"
@@ -133,6 +134,9 @@ static AVFormatContext *ffmpegdrv_oc;
 static AVOutputFormat *ffmpegdrv_fmt;
 static int file_init_done;
 
+/* frames and audio buffers on their way to the encoders */
+static ffmpegqueue_t *encoder_queue = NULL;
+
 /* audio */
 static OutputStream audio_st = { 0 };
 static AVCodec *avcodecaudio;
@@ -157,6 +161,9 @@ static unsigned int framecounter;
 static struct SwsContext *sws_ctx;
 #endif
 
+/* a queued video frame is the palette followed by the color indices */
+#define VIDEO_JOB_PALETTE_SIZE  (256 * 3)
+
 /* resources */
 static char *ffmpeg_format = NULL;
 static int format_index;
@@ -167,6 +174,7 @@ static int video_codec;
 static int video_halve_framerate;
 
 static int ffmpegdrv_init_file(void);
+static int ffmpegdrv_encode(int type, int64_t pts, uint8_t *data, size_t size);
 
 static int set_container_format(const char *val, void *param)
 {
@@ -381,8 +389,9 @@ static int ffmpegdrv_open_audio(AVFormatContext *oc, AVStream *st)
         return -1;
     }
 
+    /* filled by the emulation while the encoder may still use tmp_frame */
     ffmpegdrv_audio_in.size = audio_inbuf_samples * c->channels;
-    ffmpegdrv_audio_in.buffer = (int16_t *)audio_st.tmp_frame->data[0];
+    ffmpegdrv_audio_in.buffer = lib_malloc(ffmpegdrv_audio_in.size * sizeof(int16_t));
     return 0;
 }
 
@@ -397,6 +406,7 @@ static void ffmpegdrv_close_audio(void)
     }
 
     audio_is_open = 0;
+    lib_free(ffmpegdrv_audio_in.buffer);
     ffmpegdrv_audio_in.buffer = NULL;
     ffmpegdrv_audio_in.size = 0;
 #ifndef HAVE_FFMPEG_AVRESAMPLE
@@ -512,8 +522,8 @@ static int ffmpegmovie_init_audio(int speed, int channels, soundmovie_buffer_t *
     return 0;
 }
 
-/* triggered by soundffmpegaudio->write */
-static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+/* called via encoder_queue, on the encoder thread when there is one */
+static int ffmpegdrv_encode_audio(int64_t pts, uint8_t *data, size_t size)
 {
     int got_packet;
     int dst_nb_samples;
@@ -523,8 +533,7 @@ static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
     int ret;
 
     if (audio_st.st) {
-        audio_st.frame->pts = audio_st.next_pts;
-        audio_st.next_pts += audio_in->size;
+        audio_st.frame->pts = pts;
 
         VICE_P_AV_INIT_PACKET(&pkt);
         c = audio_st.st->codec;
@@ -532,6 +541,8 @@ static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
         frame = audio_st.tmp_frame;
 
         if (frame) {
+            memcpy(frame->data[0], data, size);
+
             /* convert samples from native format to destination codec format, using the resampler */
             /* compute destination number of samples */
 #ifndef HAVE_FFMPEG_AVRESAMPLE
@@ -572,10 +583,27 @@ static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
         }
     }
 
-    audio_in->used = 0;
     return 0;
 }
 
+/* triggered by soundffmpegaudio->write */
+static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+{
+    uint8_t *data;
+    size_t size = audio_in->size * sizeof(int16_t);
+    int ret = 0;
+
+    if (audio_st.st && encoder_queue != NULL) {
+        data = ffmpegqueue_reserve(encoder_queue, FFMPEGQUEUE_AUDIO, audio_st.next_pts, size);
+        memcpy(data, audio_in->buffer, size);
+        audio_st.next_pts += audio_in->size;
+        ret = ffmpegqueue_commit(encoder_queue);
+    }
+
+    audio_in->used = 0;
+    return ret;
+}
+
 static void ffmpegmovie_close(void)
 {
     /* just stop the whole recording */
@@ -591,29 +619,62 @@ static soundmovie_funcs_t ffmpegdrv_soundmovie_funcs = {
 /*-----------------------*/
 /* video stream encoding */
 /*-----------------------*/
-static int ffmpegdrv_fill_rgb_image(screenshot_t *screenshot, AVFrame *pic)
+/* Copy the visible part of the screen and its palette into the queue, this
+   is all the emulation has to do per frame.  */
+static int ffmpegdrv_queue_frame(screenshot_t *screenshot, int64_t pts)
 {
-    int x, y;
+    unsigned int i, num_entries;
+    int y;
     int dx, dy;
-    int colnum;
     int bufferoffset;
     int x_dim = screenshot->width;
     int y_dim = screenshot->height;
-    int pix = 0;
+    uint8_t *job;
+    uint8_t *pix;
+
+    job = ffmpegqueue_reserve(encoder_queue, FFMPEGQUEUE_VIDEO, pts,
+                              VIDEO_JOB_PALETTE_SIZE + video_width * video_height);
+
+    memset(job, 0, VIDEO_JOB_PALETTE_SIZE);
+    num_entries = screenshot->palette->num_entries < 256 ? screenshot->palette->num_entries : 256;
+    for (i = 0; i < num_entries; i++) {
+        job[i * 3] = screenshot->palette->entries[i].red;
+        job[i * 3 + 1] = screenshot->palette->entries[i].green;
+        job[i * 3 + 2] = screenshot->palette->entries[i].blue;
+    }
+
     /* center the screenshot in the video */
     dx = (video_width - x_dim) / 2;
     dy = (video_height - y_dim) / 2;
     bufferoffset = screenshot->x_offset + (dx < 0 ? -dx : 0)
         + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
 
+    pix = job + VIDEO_JOB_PALETTE_SIZE;
+    for (y = 0; y < video_height; y++) {
+        memcpy(pix, screenshot->draw_buffer + bufferoffset, video_width);
+        bufferoffset += screenshot->draw_buffer_line_size;
+        pix += video_width;
+    }
+
+    return ffmpegqueue_commit(encoder_queue);
+}
+
+/* Convert a queued frame to RGB, on the encoder thread.  */
+static int ffmpegdrv_fill_rgb_image(const uint8_t *job, AVFrame *pic)
+{
+    int x, y;
+    const uint8_t *rgb;
+    const uint8_t *colnum = job + VIDEO_JOB_PALETTE_SIZE;
+    int pix = 0;
+
     for (y = 0; y < video_height; y++) {
         for (x = 0; x < video_width; x++) {
-            colnum = screenshot->draw_buffer[bufferoffset + x];
-            pic->data[0][pix + 3*x] = screenshot->palette->entries[colnum].red;
-            pic->data[0][pix + 3*x + 1] = screenshot->palette->entries[colnum].green;
-            pic->data[0][pix + 3*x + 2] = screenshot->palette->entries[colnum].blue;
+            rgb = job + colnum[x] * 3;
+            pic->data[0][pix + 3*x] = rgb[0];
+            pic->data[0][pix + 3*x + 1] = rgb[1];
+            pic->data[0][pix + 3*x + 2] = rgb[2];
         }
-        bufferoffset += screenshot->draw_buffer_line_size;
+        colnum += video_width;
         pix += pic->linesize[0];
     }
 
@@ -828,6 +889,8 @@ static int ffmpegdrv_init_file(void)
 
     VICE_P_AVFORMAT_WRITE_HEADER(ffmpegdrv_oc,NULL);
 
+    encoder_queue = ffmpegqueue_create("ffmpegdrv", FFMPEGQUEUE_DEPTH, ffmpegdrv_encode);
+
     log_debug("ffmpegdrv: Initialized file successfully");
 
     file_init_done = 1;
@@ -890,6 +953,10 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
 {
     unsigned int i;
 
+    /* encode what is still queued before the trailer is written */
+    ffmpegqueue_destroy(encoder_queue);
+    encoder_queue = NULL;
+
     /* write the trailer, if any */
     if (file_init_done) {
         VICE_P_AV_WRITE_TRAILER(ffmpegdrv_oc);
@@ -923,35 +990,16 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
     return 0;
 }
 
-/* triggered by screenshot_record */
-static int ffmpegdrv_record(screenshot_t *screenshot)
+/* called via encoder_queue, on the encoder thread when there is one */
+static int ffmpegdrv_encode_video(int64_t pts, uint8_t *data)
 {
     AVCodecContext *c;
     int ret;
 
-    if (audio_init_done && video_init_done && !file_init_done) {
-        ffmpegdrv_init_file();
-    }
-
-    if (video_st.st == NULL || !file_init_done) {
-        return 0;
-    }
-
-   if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
-        /* drop this frame */
-        return 0;
-    }
-
-    framecounter++;
-    if (video_halve_framerate && (framecounter & 1)) {
-        /* drop every second frame */
-        return 0;
-    }
-
     c = video_st.st->codec;
 
     if (c->pix_fmt != VICE_AV_PIX_FMT_RGB24) {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.tmp_frame);
+        ffmpegdrv_fill_rgb_image(data, video_st.tmp_frame);
 
         if (sws_ctx != NULL) {
             VICE_P_SWS_SCALE(sws_ctx,
@@ -960,10 +1008,10 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
                 video_st.frame->data, video_st.frame->linesize);
         }
     } else {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.frame);
+        ffmpegdrv_fill_rgb_image(data, video_st.frame);
     }
 
-    video_st.frame->pts = video_st.next_pts++;
+    video_st.frame->pts = pts;
 
 #ifdef AVFMT_RAWPICTURE
     if (ffmpegdrv_oc->oformat->flags & AVFMT_RAWPICTURE) {
@@ -1008,6 +1056,41 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
     return 0;
 }
 
+/* encoder_queue callback */
+static int ffmpegdrv_encode(int type, int64_t pts, uint8_t *data, size_t size)
+{
+    if (type == FFMPEGQUEUE_VIDEO) {
+        return ffmpegdrv_encode_video(pts, data);
+    }
+    return ffmpegdrv_encode_audio(pts, data, size);
+}
+
+/* triggered by screenshot_record */
+static int ffmpegdrv_record(screenshot_t *screenshot)
+{
+    if (audio_init_done && video_init_done && !file_init_done) {
+        ffmpegdrv_init_file();
+    }
+
+    if (video_st.st == NULL || !file_init_done) {
+        return 0;
+    }
+
+   if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
+        /* drop this frame */
+        ffmpegqueue_count_dropped(encoder_queue);
+        return 0;
+    }
+
+    framecounter++;
+    if (video_halve_framerate && (framecounter & 1)) {
+        /* drop every second frame */
+        return 0;
+    }
+
+    return ffmpegdrv_queue_frame(screenshot, video_st.next_pts++);
+}
+
 static int ffmpegdrv_write(screenshot_t *screenshot)
 {
     return 0;
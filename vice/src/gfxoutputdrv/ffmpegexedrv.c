@@ -71,6 +71,7 @@
 #include "coproc.h"
 #include "ffmpegdrv.h"
 #include "ffmpegexedrv.h"
+#include "ffmpegqueue.h"
 #include "gfxoutput.h"
 #include "lib.h"
 #include "log.h"
@@ -242,6 +243,9 @@ typedef struct {
 } VIDEOFrame;
 static VIDEOFrame *video_st_frame;
 
+/* a queued video frame is the palette followed by the color indices */
+#define VIDEO_JOB_PALETTE_SIZE  (256 * 3)
+
 /* input audio stream */
 #define AUDIO_BUFFER_SAMPLES        0x400
 #define AUDIO_BUFFER_MAX_CHANNELS   2
@@ -268,6 +272,9 @@ static int ffmpeg_stdout = 0;
 static vice_network_socket_t *ffmpeg_video_socket = NULL;
 static vice_network_socket_t *ffmpeg_audio_socket = NULL;
 
+/* frames and audio buffers on their way to the sockets */
+static ffmpegqueue_t *encoder_queue = NULL;
+
 static char *outfilename = NULL;
 
 /******************************************************************************/
@@ -497,6 +504,9 @@ static int start_ffmpeg_executable(void)
 #endif
     log_resource_values(__FUNCTION__);
 
+    /* the dummy frames below bypass the queue, let the encoder finish first */
+    ffmpegqueue_flush(encoder_queue);
+
     /* FPS of the input, including "half framerate" */
     fpsint = fps;
     fpsfrac = (fps * 100.0f) - (fpsint * 100.0f);
@@ -795,6 +805,7 @@ static int ffmpegexe_soundmovie_init(int speed, int channels, soundmovie_buffer_
 /* triggered by soundffmpegaudio->write */
 static int ffmpegexe_soundmovie_encode(soundmovie_buffer_t *audio_in)
 {
+    uint8_t *data;
     int res;
 #ifdef DEBUG_FFMPEG_FRAMES
     double frametime = (double)framecounter / fps;
@@ -813,22 +824,19 @@ static int ffmpegexe_soundmovie_encode(soundmovie_buffer_t *audio_in)
     }
 
     if ((audio_has_codec > 0) && (audio_codec != AV_CODEC_ID_NONE)) {
-        /* FIXME: we might have an endianess problem here, we might have to swap lo/hi on BE machines */
-        if (audio_input_channels == 1) {
-            res = vice_network_send(ffmpeg_audio_socket, &audio_in->buffer[0], audio_in->used * 2, 0 /* flags */);
-            if (res != audio_in->used * 2) {
-                return -1;
-            }
-            audio_input_counter += audio_in->used;
-        } else if (audio_input_channels == 2) {
-            res = vice_network_send(ffmpeg_audio_socket, &audio_in->buffer[0], audio_in->used * 2, 0 /* flags */);
-            if (res != audio_in->used * 2) {
+        if (audio_input_channels != 1 && audio_input_channels != 2) {
+            return -1;
+        }
+        if (encoder_queue != NULL) {
+            /* FIXME: we might have an endianess problem here, we might have to swap lo/hi on BE machines */
+            data = ffmpegqueue_reserve(encoder_queue, FFMPEGQUEUE_AUDIO, 0, audio_in->used * 2);
+            memcpy(data, &audio_in->buffer[0], audio_in->used * 2);
+            res = ffmpegqueue_commit(encoder_queue);
+            if (res < 0) {
                 return -1;
             }
-            audio_input_counter += audio_in->used / 2;
-        } else {
-            return -1;
         }
+        audio_input_counter += audio_in->used / audio_input_channels;
     }
 
     audio_in->used = 0;
@@ -854,36 +862,88 @@ static soundmovie_funcs_t ffmpegexedrv_soundmovie_funcs = {
    video stream encoding
  *****************************************************************************/
 
-static int video_fill_rgb_image(screenshot_t *screenshot, VIDEOFrame *pic)
+/* Copy the visible part of the screen and its palette into the queue, this
+   is all the emulation has to do per frame.  */
+static int video_queue_frame(screenshot_t *screenshot)
 {
-    int x, y;
+    unsigned int i, num_entries;
+    int y;
     int dx, dy;
-    int colnum;
     int bufferoffset;
     int x_dim = screenshot->width;
     int y_dim = screenshot->height;
-    int pix = 0;
+    uint8_t *job;
+    uint8_t *pix;
+
+    if (encoder_queue == NULL) {
+        return 0;
+    }
+
+    job = ffmpegqueue_reserve(encoder_queue, FFMPEGQUEUE_VIDEO, (int64_t)framecounter,
+                              VIDEO_JOB_PALETTE_SIZE + video_width * video_height);
+
+    memset(job, 0, VIDEO_JOB_PALETTE_SIZE);
+    num_entries = screenshot->palette->num_entries < 256 ? screenshot->palette->num_entries : 256;
+    for (i = 0; i < num_entries; i++) {
+        job[i * 3] = screenshot->palette->entries[i].red;
+        job[i * 3 + 1] = screenshot->palette->entries[i].green;
+        job[i * 3 + 2] = screenshot->palette->entries[i].blue;
+    }
+
     /* center the screenshot in the video */
-    pic->linesize = video_width * INPUT_VIDEO_BPP;
     dx = (video_width - x_dim) / 2;
     dy = (video_height - y_dim) / 2;
     bufferoffset = screenshot->x_offset + (dx < 0 ? -dx : 0)
         + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
 
+    pix = job + VIDEO_JOB_PALETTE_SIZE;
+    for (y = 0; y < video_height; y++) {
+        memcpy(pix, screenshot->draw_buffer + bufferoffset, video_width);
+        bufferoffset += screenshot->draw_buffer_line_size;
+        pix += video_width;
+    }
+
+    return ffmpegqueue_commit(encoder_queue);
+}
+
+/* Convert a queued frame to RGB, on the encoder thread.  */
+static int video_fill_rgb_image(const uint8_t *job, VIDEOFrame *pic)
+{
+    int x, y;
+    const uint8_t *rgb;
+    const uint8_t *colnum = job + VIDEO_JOB_PALETTE_SIZE;
+    int pix = 0;
+
+    pic->linesize = video_width * INPUT_VIDEO_BPP;
+
     for (y = 0; y < video_height; y++) {
         for (x = 0; x < video_width; x++) {
-            colnum = screenshot->draw_buffer[bufferoffset + x];
-            pic->data[pix + INPUT_VIDEO_BPP * x] = screenshot->palette->entries[colnum].red;
-            pic->data[pix + INPUT_VIDEO_BPP * x + 1] = screenshot->palette->entries[colnum].green;
-            pic->data[pix + INPUT_VIDEO_BPP * x + 2] = screenshot->palette->entries[colnum].blue;
+            rgb = job + colnum[x] * 3;
+            pic->data[pix + INPUT_VIDEO_BPP * x] = rgb[0];
+            pic->data[pix + INPUT_VIDEO_BPP * x + 1] = rgb[1];
+            pic->data[pix + INPUT_VIDEO_BPP * x + 2] = rgb[2];
         }
-        bufferoffset += screenshot->draw_buffer_line_size;
+        colnum += video_width;
         pix += pic->linesize;
     }
 
     return 0;
 }
 
+/* encoder_queue callback, runs on the encoder thread when there is one */
+static int ffmpegexedrv_encode(int type, int64_t pts, uint8_t *data, size_t size)
+{
+    int res;
+
+    if (type == FFMPEGQUEUE_VIDEO) {
+        video_fill_rgb_image(data, video_st_frame);
+        return write_video_frame(video_st_frame) != 0 ? -1 : 0;
+    }
+
+    res = vice_network_send(ffmpeg_audio_socket, data, size, 0 /* flags */);
+    return res != (int)size ? -1 : 0;
+}
+
 /* called by ffmpegexedrv_open_video() */
 static VIDEOFrame* video_alloc_picture(int bpp, int width, int height)
 {
@@ -994,6 +1054,8 @@ static int ffmpegexedrv_init_file(void)
         return -1;
     }
 
+    encoder_queue = ffmpegqueue_create("ffmpegexedrv", FFMPEGQUEUE_DEPTH, ffmpegexedrv_encode);
+
     log_debug("ffmpegexedrv: Initialized file successfully");
 
     /*start_ffmpeg_executable();*/
@@ -1054,6 +1116,10 @@ static int ffmpegexedrv_close(screenshot_t *screenshot)
 
     soundmovie_stop();
 
+    /* write out what is still queued before the sockets go away */
+    ffmpegqueue_destroy(encoder_queue);
+    encoder_queue = NULL;
+
     ffmpegexedrv_close_video();
     ffmpegexedrv_close_audio();
 
@@ -1100,15 +1166,16 @@ static int ffmpegexedrv_record(screenshot_t *screenshot)
     if (frametime > (audiotime + (time_base * 1.5f))) {
         /* drop one frame */
         framecounter--;
+        if (encoder_queue != NULL) {
+            ffmpegqueue_count_dropped(encoder_queue);
+        }
         DBG(("video is ahead, dropping a frame (framecount:%lu, audiocount:%lu frametime:%f, audiotime:%f)",
             framecounter, audio_input_counter, frametime, audiotime));
         return 0;
     }
 
     /*DBGFRAMES(("ffmpegexedrv_record (%u)", framecounter));*/
-    video_fill_rgb_image(screenshot, video_st_frame);
-
-    write_video_frame(video_st_frame);
+    video_queue_frame(screenshot);
 
     /* the video is late */
     if (frametime < (audiotime - (time_base * 1.5f))) {
@@ -1116,7 +1183,7 @@ static int ffmpegexedrv_record(screenshot_t *screenshot)
         framecounter++;
         DBG(("video is late, inserting a frame (framecount:%lu, audiocount:%lu frametime:%f, audiotime:%f)",
             framecounter, audio_input_counter, frametime, audiotime));
-        write_video_frame(video_st_frame);
+        video_queue_frame(screenshot);
     }
     return 0;
 }
@@ -0,0 +1,303 @@
+/*
+ * ffmpegqueue.c - Bounded queue between the emulation and the movie encoder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+    The movie drivers copy each video frame and audio buffer into a slot of
+    this queue and return to the emulation; a single encoder thread takes the
+    slots in order and does the conversion, encoding and writing. When all
+    slots are taken the emulation waits for the encoder (back-pressure), so
+    no data is lost when the encoder can not keep up.
+
+    Without threads the jobs are encoded right away in ffmpegqueue_commit().
+*/
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
+#include "ffmpegqueue.h"
+#include "lib.h"
+#include "log.h"
+
+typedef struct ffmpegqueue_slot_s {
+    int type;
+    int64_t pts;
+    uint8_t *data;
+    size_t size;
+    size_t allocated;
+} ffmpegqueue_slot_t;
+
+struct ffmpegqueue_s {
+    char *name;
+    ffmpegqueue_encode_t encode;
+    ffmpegqueue_slot_t *slots;
+    unsigned int depth;     /* number of slots */
+    unsigned int limit;     /* number of jobs that may be pending */
+
+    /* statistics, only touched by the emulation side except for errors */
+    unsigned int video_frames;
+    unsigned int audio_buffers;
+    unsigned int dropped_frames;
+    unsigned int waits;
+    unsigned int max_used;
+    unsigned long used_sum;
+    unsigned int errors;
+
+#ifdef USE_VICE_THREAD
+    pthread_t thread;
+    int thread_running;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_cond_t idle;
+
+    /* protected by lock */
+    unsigned int head;      /* next slot handed out by ffmpegqueue_reserve */
+    unsigned int tail;      /* next slot taken by the encoder */
+    unsigned int used;      /* committed slots not yet encoded */
+    int quit;
+#endif
+};
+
+static void ffmpegqueue_slot_fit(ffmpegqueue_slot_t *slot, size_t size)
+{
+    if (slot->allocated < size) {
+        slot->data = lib_realloc(slot->data, size);
+        slot->allocated = size;
+    }
+    slot->size = size;
+}
+
+static void ffmpegqueue_count(ffmpegqueue_t *queue, ffmpegqueue_slot_t *slot, unsigned int used)
+{
+    if (slot->type == FFMPEGQUEUE_VIDEO) {
+        queue->video_frames++;
+    } else {
+        queue->audio_buffers++;
+    }
+    if (used > queue->max_used) {
+        queue->max_used = used;
+    }
+    queue->used_sum += used;
+}
+
+#ifdef USE_VICE_THREAD
+
+static void *ffmpegqueue_thread(void *arg)
+{
+    ffmpegqueue_t *queue = arg;
+    ffmpegqueue_slot_t *slot;
+    int ret;
+
+    pthread_mutex_lock(&queue->lock);
+    for (;;) {
+        while (queue->used == 0 && !queue->quit) {
+            pthread_cond_wait(&queue->not_empty, &queue->lock);
+        }
+        /* what is queued still gets written before quitting */
+        if (queue->used == 0) {
+            break;
+        }
+        slot = &queue->slots[queue->tail];
+        pthread_mutex_unlock(&queue->lock);
+
+        ret = queue->encode(slot->type, slot->pts, slot->data, slot->size);
+
+        pthread_mutex_lock(&queue->lock);
+        if (ret < 0 && queue->errors++ == 0) {
+            log_error(LOG_DEFAULT, "%s: error while encoding, further errors are only counted.", queue->name);
+        }
+        queue->tail = (queue->tail + 1) % queue->depth;
+        queue->used--;
+        pthread_cond_signal(&queue->not_full);
+        if (queue->used == 0) {
+            pthread_cond_broadcast(&queue->idle);
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return NULL;
+}
+
+#endif
+
+/* Create a queue holding up to `depth' pending jobs, which are handed to
+   `encode', and start its encoder thread.  */
+ffmpegqueue_t *ffmpegqueue_create(const char *name, unsigned int depth, ffmpegqueue_encode_t encode)
+{
+    ffmpegqueue_t *queue = lib_calloc(1, sizeof(ffmpegqueue_t));
+
+    queue->name = lib_strdup(name);
+    queue->encode = encode;
+#ifdef USE_VICE_THREAD
+    /* one more slot than pending jobs, it is filled while the others wait */
+    queue->limit = depth < 1 ? 1 : depth;
+    queue->depth = queue->limit + 1;
+    queue->slots = lib_calloc(queue->depth, sizeof(ffmpegqueue_slot_t));
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    pthread_cond_init(&queue->idle, NULL);
+
+    if (pthread_create(&queue->thread, NULL, ffmpegqueue_thread, queue) == 0) {
+        queue->thread_running = 1;
+    } else {
+        log_warning(LOG_DEFAULT, "%s: cannot start encoder thread, encoding synchronously.", queue->name);
+    }
+#else
+    queue->limit = 1;
+    queue->depth = 1;
+    queue->slots = lib_calloc(1, sizeof(ffmpegqueue_slot_t));
+#endif
+
+    return queue;
+}
+
+/* Encode everything still queued, stop the encoder thread, log the
+   statistics and free the queue.  */
+void ffmpegqueue_destroy(ffmpegqueue_t *queue)
+{
+    unsigned int i, jobs;
+
+    if (queue == NULL) {
+        return;
+    }
+
+#ifdef USE_VICE_THREAD
+    if (queue->thread_running) {
+        pthread_mutex_lock(&queue->lock);
+        queue->quit = 1;
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+        pthread_join(queue->thread, NULL);
+    }
+    pthread_cond_destroy(&queue->idle);
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+#endif
+
+    jobs = queue->video_frames + queue->audio_buffers;
+    log_message(LOG_DEFAULT,
+                "%s: %u video frames, %u audio buffers, %u frames dropped, "
+                "queue depth max %u/%u avg %.1f, %u waits for the encoder, %u errors.",
+                queue->name, queue->video_frames, queue->audio_buffers,
+                queue->dropped_frames, queue->max_used, queue->limit,
+                jobs ? (double)queue->used_sum / jobs : 0.0,
+                queue->waits, queue->errors);
+
+    for (i = 0; i < queue->depth; i++) {
+        lib_free(queue->slots[i].data);
+    }
+    lib_free(queue->slots);
+    lib_free(queue->name);
+    lib_free(queue);
+}
+
+/* Get a buffer of `size' bytes for the next job; the caller copies its data
+   there and then calls ffmpegqueue_commit().  Waits while all slots are
+   pending.  */
+uint8_t *ffmpegqueue_reserve(ffmpegqueue_t *queue, int type, int64_t pts, size_t size)
+{
+    ffmpegqueue_slot_t *slot;
+
+#ifdef USE_VICE_THREAD
+    if (queue->thread_running) {
+        pthread_mutex_lock(&queue->lock);
+        if (queue->used >= queue->limit) {
+            queue->waits++;
+            do {
+                pthread_cond_wait(&queue->not_full, &queue->lock);
+            } while (queue->used >= queue->limit);
+        }
+        slot = &queue->slots[queue->head];
+        pthread_mutex_unlock(&queue->lock);
+    } else
+#endif
+    {
+        slot = &queue->slots[0];
+    }
+
+    /* the slot at head is owned by the caller until it is committed */
+    ffmpegqueue_slot_fit(slot, size);
+    slot->type = type;
+    slot->pts = pts;
+
+    return slot->data;
+}
+
+/* Hand the job filled in after ffmpegqueue_reserve() to the encoder.
+   Returns the result of the encoder when encoding synchronously, 0
+   otherwise.  */
+int ffmpegqueue_commit(ffmpegqueue_t *queue)
+{
+    ffmpegqueue_slot_t *slot;
+    int ret;
+
+#ifdef USE_VICE_THREAD
+    if (queue->thread_running) {
+        pthread_mutex_lock(&queue->lock);
+        slot = &queue->slots[queue->head];
+        queue->head = (queue->head + 1) % queue->depth;
+        queue->used++;
+        ffmpegqueue_count(queue, slot, queue->used);
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+        return 0;
+    }
+#endif
+
+    slot = &queue->slots[0];
+    ffmpegqueue_count(queue, slot, 1);
+    ret = queue->encode(slot->type, slot->pts, slot->data, slot->size);
+    if (ret < 0) {
+        queue->errors++;
+    }
+    return ret;
+}
+
+/* Wait until the encoder has handled all committed jobs.  */
+void ffmpegqueue_flush(ffmpegqueue_t *queue)
+{
+#ifdef USE_VICE_THREAD
+    if (queue != NULL && queue->thread_running) {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->used > 0) {
+            pthread_cond_wait(&queue->idle, &queue->lock);
+        }
+        pthread_mutex_unlock(&queue->lock);
+    }
+#endif
+}
+
+/* Count a video frame the driver dropped to keep audio and video in sync.  */
+void ffmpegqueue_count_dropped(ffmpegqueue_t *queue)
+{
+    queue->dropped_frames++;
+}
@@ -0,0 +1,51 @@
+/*
+ * ffmpegqueue.h - Bounded queue between the emulation and the movie encoder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_FFMPEGQUEUE_H
+#define VICE_FFMPEGQUEUE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+#define FFMPEGQUEUE_VIDEO   0
+#define FFMPEGQUEUE_AUDIO   1
+
+/* Default number of video frames and audio buffers that may be pending.  */
+#define FFMPEGQUEUE_DEPTH   16
+
+typedef struct ffmpegqueue_s ffmpegqueue_t;
+
+/* Encodes one queued job.  Runs on the encoder thread when there is one,
+   otherwise directly from ffmpegqueue_commit().  */
+typedef int (*ffmpegqueue_encode_t)(int type, int64_t pts, uint8_t *data, size_t size);
+
+ffmpegqueue_t *ffmpegqueue_create(const char *name, unsigned int depth, ffmpegqueue_encode_t encode);
+void ffmpegqueue_destroy(ffmpegqueue_t *queue);
+
+uint8_t *ffmpegqueue_reserve(ffmpegqueue_t *queue, int type, int64_t pts, size_t size);
+int ffmpegqueue_commit(ffmpegqueue_t *queue);
+void ffmpegqueue_flush(ffmpegqueue_t *queue);
+void ffmpegqueue_count_dropped(ffmpegqueue_t *queue);
+
+#endif
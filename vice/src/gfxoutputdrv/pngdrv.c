@@ -31,13 +31,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include <png.h>
 #include <zlib.h>
 
 #include "archdep.h"
+#include "cmdline.h"
 #include "gfxoutput.h"
 #include "lib.h"
+#include "log.h"
+#include "palette.h"
 #include "pngdrv.h"
+#include "resources.h"
 #include "screenshot.h"
 #include "types.h"
 #include "util.h"
@@ -52,8 +60,40 @@ typedef struct gfxoutputdrv_data_s {
     unsigned int line;
 } gfxoutputdrv_data_t;
 
+/* A screenshot captured by pngdrv_save(), compressed and written later.  */
+typedef struct pngdrv_job_s {
+    FILE *fd;
+    char *ext_filename;
+    unsigned int width;
+    unsigned int height;
+    int level;
+    int indexed;
+    unsigned int num_colors;
+    png_color palette[256];
+    uint8_t *pixels;            /* width * height palette indices */
+    struct pngdrv_job_s *next;
+} pngdrv_job_t;
+
 static gfxoutputdrv_t png_drv;
 
+/* zlib compression level, 0 (store) to 9 (best) */
+static int png_compression_level = Z_BEST_COMPRESSION;
+
+/* write screenshots as 8 bit palette images instead of RGBA */
+static int png_indexed = 0;
+
+#ifdef HAVE_PTHREADS
+static pthread_t png_thread;
+static int png_thread_running = 0;
+static pthread_mutex_t png_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t png_queued = PTHREAD_COND_INITIALIZER;
+
+/* protected by png_lock */
+static pngdrv_job_t *png_queue_head = NULL;
+static pngdrv_job_t *png_queue_tail = NULL;
+static int png_quit = 0;
+#endif
+
 static int pngdrv_open(screenshot_t *screenshot, const char *filename)
 {
     gfxoutputdrv_data_t *sdata;
@@ -103,7 +143,7 @@ static int pngdrv_open(screenshot_t *screenshot, const char *filename)
     sdata->data = lib_malloc(screenshot->width * 4);
 
     png_init_io(sdata->png_ptr, sdata->fd);
-    png_set_compression_level(sdata->png_ptr, Z_BEST_COMPRESSION);
+    png_set_compression_level(sdata->png_ptr, png_compression_level);
 
     png_set_IHDR(sdata->png_ptr, sdata->info_ptr, screenshot->width, screenshot->height,
                  8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
@@ -149,23 +189,206 @@ static int pngdrv_close(screenshot_t *screenshot)
     return 0;
 }
 
+static void pngdrv_job_free(pngdrv_job_t *job)
+{
+    lib_free(job->pixels);
+    lib_free(job->ext_filename);
+    lib_free(job);
+}
+
+/* Compress and write a captured screenshot, close its file and free the
+   job.  Runs on the writer thread when there is one.  */
+static int pngdrv_write_job(pngdrv_job_t *job)
+{
+    png_structp png_ptr;
+    png_infop info_ptr;
+    /* volatile, it is freed after a longjmp from libpng */
+    uint8_t * volatile row = NULL;
+    unsigned int x, y;
+    uint8_t *src;
+
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, (void *)NULL, NULL, NULL);
+    if (png_ptr == NULL) {
+        goto fail;
+    }
+
+    info_ptr = png_create_info_struct(png_ptr);
+    if (info_ptr == NULL) {
+        png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
+        goto fail;
+    }
+
+#if (PNG_LIBPNG_VER < 10006)
+    if (setjmp(png_ptr->jmpbuf)) {
+#else
+    if (setjmp(png_jmpbuf(png_ptr))) {
+#endif
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        lib_free(row);
+        goto fail;
+    }
+
+    png_init_io(png_ptr, job->fd);
+    png_set_compression_level(png_ptr, job->level);
+
+    if (job->indexed) {
+        png_set_IHDR(png_ptr, info_ptr, job->width, job->height,
+                     8, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_set_PLTE(png_ptr, info_ptr, job->palette, (int)job->num_colors);
+        png_write_info(png_ptr, info_ptr);
+
+        for (y = 0; y < job->height; y++) {
+            png_write_row(png_ptr, (png_bytep)(job->pixels + y * job->width));
+        }
+    } else {
+        png_set_IHDR(png_ptr, info_ptr, job->width, job->height,
+                     8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png_ptr, info_ptr);
+
+#ifdef PNG_READ_INVERT_ALPHA_SUPPORTED
+        png_set_invert_alpha(png_ptr);
+#endif
+        row = lib_malloc(job->width * 4);
+
+        for (y = 0; y < job->height; y++) {
+            src = job->pixels + y * job->width;
+            for (x = 0; x < job->width; x++) {
+                row[x * 4] = job->palette[src[x]].red;
+                row[x * 4 + 1] = job->palette[src[x]].green;
+                row[x * 4 + 2] = job->palette[src[x]].blue;
+                row[x * 4 + 3] = 0;
+            }
+            png_write_row(png_ptr, (png_bytep)row);
+        }
+    }
+
+    png_write_end(png_ptr, info_ptr);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    lib_free(row);
+
+    if (fclose(job->fd) != 0) {
+        job->fd = NULL;
+        goto fail;
+    }
+    pngdrv_job_free(job);
+    return 0;
+
+fail:
+    log_error(LOG_DEFAULT, "PNG: error while writing `%s'.", job->ext_filename);
+    if (job->fd != NULL) {
+        fclose(job->fd);
+    }
+    pngdrv_job_free(job);
+    return -1;
+}
+
+#ifdef HAVE_PTHREADS
+
+static void *pngdrv_thread(void *arg)
+{
+    pngdrv_job_t *job;
+
+    pthread_mutex_lock(&png_lock);
+    for (;;) {
+        while (png_queue_head == NULL && !png_quit) {
+            pthread_cond_wait(&png_queued, &png_lock);
+        }
+        /* what is queued still gets written before quitting */
+        if (png_queue_head == NULL) {
+            break;
+        }
+        job = png_queue_head;
+        png_queue_head = job->next;
+        if (png_queue_head == NULL) {
+            png_queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&png_lock);
+
+        pngdrv_write_job(job);
+
+        pthread_mutex_lock(&png_lock);
+    }
+    pthread_mutex_unlock(&png_lock);
+
+    return NULL;
+}
+
+#endif
+
+/* Hand a captured screenshot to the writer thread, starting it when needed.
+   Without threads the screenshot is written right away.  */
+static int pngdrv_queue_job(pngdrv_job_t *job)
+{
+#ifdef HAVE_PTHREADS
+    pthread_mutex_lock(&png_lock);
+    if (!png_thread_running) {
+        png_quit = 0;
+        if (pthread_create(&png_thread, NULL, pngdrv_thread, NULL) == 0) {
+            png_thread_running = 1;
+        } else {
+            log_warning(LOG_DEFAULT, "PNG: cannot start writer thread, writing synchronously.");
+        }
+    }
+    if (png_thread_running) {
+        job->next = NULL;
+        if (png_queue_tail != NULL) {
+            png_queue_tail->next = job;
+        } else {
+            png_queue_head = job;
+        }
+        png_queue_tail = job;
+        pthread_cond_signal(&png_queued);
+        pthread_mutex_unlock(&png_lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&png_lock);
+#endif
+    return pngdrv_write_job(job);
+}
+
+/* Capture the screenshot into a buffer of palette indices, the compression
+   and writing is done by pngdrv_write_job().  The file is opened here, so
+   the caller still learns about an unwritable name.  */
 static int pngdrv_save(screenshot_t *screenshot, const char *filename)
 {
-    if (pngdrv_open(screenshot, filename) < 0) {
+    pngdrv_job_t *job;
+    unsigned int i;
+
+    job = lib_calloc(1, sizeof(pngdrv_job_t));
+
+    job->ext_filename = util_add_extension_const(filename, png_drv.default_extension);
+    job->fd = fopen(job->ext_filename, MODE_WRITE);
+
+    if (job->fd == NULL) {
+        lib_free(job->ext_filename);
+        lib_free(job);
         return -1;
     }
 
-    for (screenshot->gfxoutputdrv_data->line = 0;
-         screenshot->gfxoutputdrv_data->line < screenshot->height;
-         (screenshot->gfxoutputdrv_data->line)++) {
-        pngdrv_write(screenshot);
+    job->width = screenshot->width;
+    job->height = screenshot->height;
+    job->level = png_compression_level;
+    job->indexed = png_indexed;
+
+    job->num_colors = screenshot->palette->num_entries;
+    if (job->num_colors > 256) {
+        job->num_colors = 256;
+    }
+    for (i = 0; i < job->num_colors; i++) {
+        job->palette[i].red = screenshot->palette->entries[i].red;
+        job->palette[i].green = screenshot->palette->entries[i].green;
+        job->palette[i].blue = screenshot->palette->entries[i].blue;
     }
 
-    if (pngdrv_close(screenshot) < 0) {
-        return -1;
+    job->pixels = lib_malloc(job->width * job->height);
+    for (i = 0; i < job->height; i++) {
+        (screenshot->convert_line)(screenshot, job->pixels + i * job->width, i,
+                                   SCREENSHOT_MODE_PALETTE);
     }
 
-    return 0;
+    return pngdrv_queue_job(job);
 }
 
 #ifdef FEATURE_CPUMEMHISTORY
@@ -241,7 +464,7 @@ static int pngdrv_open_memmap(const char *filename, int x_size, int y_size, uint
     pngdrv_memmap_png_data = lib_malloc(x_size * 4);
 
     png_init_io(pngdrv_memmap_png_ptr, pngdrv_memmap_fd);
-    png_set_compression_level(pngdrv_memmap_png_ptr, Z_BEST_COMPRESSION);
+    png_set_compression_level(pngdrv_memmap_png_ptr, png_compression_level);
 
     png_set_IHDR(pngdrv_memmap_png_ptr, pngdrv_memmap_info_ptr, x_size, y_size,
                  8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
@@ -276,6 +499,77 @@ static int pngdrv_save_memmap(const char *filename, int x_size, int y_size, uint
 }
 #endif
 
+/* Driver API gfxoutputdrv_t.shutdown, also makes sure that the screenshots
+   saved at exit are completely written.  */
+static void pngdrv_shutdown(void)
+{
+#ifdef HAVE_PTHREADS
+    if (png_thread_running) {
+        pthread_mutex_lock(&png_lock);
+        png_quit = 1;
+        pthread_cond_signal(&png_queued);
+        pthread_mutex_unlock(&png_lock);
+        pthread_join(png_thread, NULL);
+        png_thread_running = 0;
+    }
+#endif
+}
+
+/*---------- Resources ------------------------------------------------*/
+
+static int set_png_compression_level(int val, void *param)
+{
+    if (val < Z_NO_COMPRESSION || val > Z_BEST_COMPRESSION) {
+        return -1;
+    }
+    png_compression_level = val;
+    return 0;
+}
+
+static int set_png_indexed(int val, void *param)
+{
+    png_indexed = val ? 1 : 0;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "PNGCompressionLevel", Z_BEST_COMPRESSION, RES_EVENT_NO, NULL,
+      &png_compression_level, set_png_compression_level, NULL },
+    { "PNGIndexed", 0, RES_EVENT_NO, NULL,
+      &png_indexed, set_png_indexed, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+/* Driver API gfxoutputdrv_t.resources_init */
+static int pngdrv_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+/*---------- Commandline options --------------------------------------*/
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-pngcompressionlevel", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "PNGCompressionLevel", NULL,
+      "<0-9>", "Set the zlib compression level of PNG files (0: none, 9: best)" },
+    { "-pngindexed", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "PNGIndexed", (resource_value_t)1,
+      NULL, "Save PNG screenshots as 8 bit palette images" },
+    { "+pngindexed", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "PNGIndexed", (resource_value_t)0,
+      NULL, "Save PNG screenshots as RGBA images" },
+    CMDLINE_LIST_END
+};
+
+/* Driver API gfxoutputdrv_t.cmdline_options_init */
+static int pngdrv_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+/*---------------------------------------------------------------------*/
+
 static gfxoutputdrv_t png_drv =
 {
     "PNG",
@@ -288,9 +582,9 @@ static gfxoutputdrv_t png_drv =
     pngdrv_save,
     NULL,
     NULL,
-    NULL,
-    NULL,
-    NULL
+    pngdrv_shutdown,
+    pngdrv_resources_init,
+    pngdrv_cmdline_options_init
 #ifdef FEATURE_CPUMEMHISTORY
     , pngdrv_save_memmap
 #endif
@@ -298,9 +592,7 @@ static gfxoutputdrv_t png_drv =
 
 void gfxoutput_init_png(int help)
 {
-    if (help) {
-        return;
-    }
+    /* also registered for -help, so the options above get listed */
     gfxoutput_register(&png_drv);
 }
 #endif
@@ -31,6 +31,8 @@
 #include <limits.h>
 #include <errno.h>
 #include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "hvsc.h"
 #include "hvsc_defs.h"
@@ -425,6 +427,226 @@ long hvsc_read_file(uint8_t **dest, const char *path)
 }
 
 
+/** \brief  Get next line from a buffer holding a text file
+ *
+ * Terminates the line at \a *pos with a nul-byte, strips a Windows CR and
+ * moves \a *pos to the start of the next line. The buffer is modified in
+ * place, so it must be writable.
+ *
+ * \param[in,out]   pos pointer to current position in the buffer
+ * \param[in]       end end of the buffer
+ *
+ * \return  line or `NULL` when \a *pos has reached \a end
+ */
+char *hvsc_text_next_line(char **pos, char *end)
+{
+    char *line = *pos;
+    char *eol;
+
+    if (line >= end) {
+        return NULL;
+    }
+
+    eol = memchr(line, '\n', (size_t)(end - line));
+    if (eol == NULL) {
+        eol = end;
+        *pos = end;
+    } else {
+        *pos = eol + 1;
+    }
+    *eol = '\0';
+    if (eol > line && *(eol - 1) == '\r') {
+        *(eol - 1) = '\0';
+    }
+    return line;
+}
+
+
+/** \brief  Get size and modification time of \a path
+ *
+ * \param[in]   path    path to file
+ * \param[out]  stamp   size and modification time of \a path
+ *
+ * \return  bool
+ */
+bool hvsc_file_get_stamp(const char *path, hvsc_file_stamp_t *stamp)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        hvsc_errno = HVSC_ERR_IO;
+        return false;
+    }
+    stamp->size = (long)st.st_size;
+    stamp->mtime = st.st_mtime;
+    return true;
+}
+
+
+/** \brief  Determine if two file stamps are equal
+ *
+ * \param[in]   s1  first file stamp
+ * \param[in]   s2  second file stamp
+ *
+ * \return  bool
+ */
+bool hvsc_file_stamp_equal(const hvsc_file_stamp_t *s1,
+                           const hvsc_file_stamp_t *s2)
+{
+    return s1->size == s2->size && s1->mtime == s2->mtime;
+}
+
+
+/** \brief  Number of chars of the keys to compare when sorting an index
+ *
+ * 0 means compare the full keys.
+ */
+static size_t index_keylen;
+
+
+/** \brief  Compare two keys, using at most \a keylen chars if non-zero
+ *
+ * \param[in]   k1      first key
+ * \param[in]   k2      second key
+ * \param[in]   keylen  number of chars to compare (0 = full keys)
+ *
+ * \return  <0, 0 or >0, like strcmp()
+ */
+static int index_key_cmp(const char *k1, const char *k2, size_t keylen)
+{
+    if (keylen > 0) {
+        return strncmp(k1, k2, keylen);
+    }
+    return strcmp(k1, k2);
+}
+
+
+/** \brief  qsort() callback for hvsc_index_sort()
+ *
+ * Entries with equal keys are sorted on offset, so the first occurrence of a
+ * key in the file comes first, just like a linear scan would find it.
+ *
+ * \param[in]   p1  first entry
+ * \param[in]   p2  second entry
+ *
+ * \return  <0, 0 or >0
+ */
+static int index_entry_cmp(const void *p1, const void *p2)
+{
+    const hvsc_index_entry_t *e1 = p1;
+    const hvsc_index_entry_t *e2 = p2;
+    int result;
+
+    result = index_key_cmp(e1->key, e2->key, index_keylen);
+    if (result == 0) {
+        result = (e1->offset > e2->offset) - (e1->offset < e2->offset);
+    }
+    return result;
+}
+
+
+/** \brief  Initialize \a index
+ *
+ * \param[out]  index   index
+ * \param[in]   keylen  number of chars of the keys to compare, 0 to compare
+ *                      the full (nul-terminated) keys
+ */
+void hvsc_index_init(hvsc_index_t *index, size_t keylen)
+{
+    index->entries = NULL;
+    index->count = 0;
+    index->size = 0;
+    index->keylen = keylen;
+}
+
+
+/** \brief  Add entry to \a index
+ *
+ * The \a key isn't copied, so it must stay valid for the lifetime of the
+ * index.
+ *
+ * \param[in,out]   index   index
+ * \param[in]       key     key
+ * \param[in]       offset  offset of the entry
+ * \param[in]       lineno  line number of the entry
+ */
+void hvsc_index_add(hvsc_index_t *index, const char *key,
+                    long offset, long lineno)
+{
+    hvsc_index_entry_t *entry;
+
+    if (index->count == index->size) {
+        index->size = index->size == 0 ? 1024 : index->size * 2;
+        index->entries = hvsc_realloc(index->entries,
+                                      index->size * sizeof *(index->entries));
+    }
+    entry = &(index->entries[index->count++]);
+    entry->key = key;
+    entry->offset = offset;
+    entry->lineno = lineno;
+}
+
+
+/** \brief  Sort \a index on key
+ *
+ * Must be called after adding entries and before looking up keys.
+ *
+ * \param[in,out]   index   index
+ */
+void hvsc_index_sort(hvsc_index_t *index)
+{
+    if (index->count > 0) {
+        index_keylen = index->keylen;
+        qsort(index->entries, index->count, sizeof *(index->entries),
+              index_entry_cmp);
+    }
+}
+
+
+/** \brief  Look up \a key in \a index
+ *
+ * Uses a binary search for the first entry matching \a key.
+ *
+ * \param[in]   index   index, sorted with hvsc_index_sort()
+ * \param[in]   key     key to look up
+ *
+ * \return  entry or `NULL` when not found
+ */
+const hvsc_index_entry_t *hvsc_index_find(const hvsc_index_t *index,
+                                          const char *key)
+{
+    size_t lo = 0;
+    size_t hi = index->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index_key_cmp(index->entries[mid].key, key, index->keylen) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < index->count
+            && index_key_cmp(index->entries[lo].key, key, index->keylen) == 0) {
+        return &(index->entries[lo]);
+    }
+    hvsc_errno = HVSC_ERR_NOT_FOUND;
+    return NULL;
+}
+
+
+/** \brief  Free memory used by \a index
+ *
+ * \param[in,out]   index   index
+ */
+void hvsc_index_free(hvsc_index_t *index)
+{
+    hvsc_free(index->entries);
+    hvsc_index_init(index, index->keylen);
+}
+
+
 /** \brief  Copy at most \a n chars of \a s
  *
  * This function appends a nul-byte after \a n bytes.
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 #include "hvsc_defs.h"
 
@@ -65,6 +66,36 @@
 #endif
 
 
+/** \brief  Size and modification time of a file
+ *
+ * Used to find out if a file has changed since an index was built from it.
+ */
+typedef struct hvsc_file_stamp_s {
+    long    size;   /**< size of the file in bytes */
+    time_t  mtime;  /**< modification time of the file */
+} hvsc_file_stamp_t;
+
+
+/** \brief  Entry in an index of one of the HVSC text files
+ */
+typedef struct hvsc_index_entry_s {
+    const char *key;    /**< key, points into the text the index was built from */
+    long        offset; /**< offset in bytes of the entry */
+    long        lineno; /**< line number of the entry */
+} hvsc_index_entry_t;
+
+
+/** \brief  Sorted index of one of the HVSC text files
+ */
+typedef struct hvsc_index_s {
+    hvsc_index_entry_t *entries;    /**< entries, sorted on key */
+    size_t              count;      /**< number of entries */
+    size_t              size;       /**< number of allocated entries */
+    size_t              keylen;     /**< chars of the keys to compare, 0 means
+                                         compare the full keys */
+} hvsc_index_t;
+
+
 extern char *hvsc_root_path;
 extern char *hvsc_sldb_path;
 extern char *hvsc_stil_path;
@@ -85,6 +116,18 @@ void        hvsc_text_file_init_handle(hvsc_text_file_t *handle);
 bool        hvsc_text_file_open(const char *path, hvsc_text_file_t *handle);
 const char *hvsc_text_file_read(hvsc_text_file_t *handle);
 void        hvsc_text_file_close(hvsc_text_file_t *handle);
+char *      hvsc_text_next_line(char **pos, char *end);
+
+bool        hvsc_file_get_stamp(const char *path, hvsc_file_stamp_t *stamp);
+bool        hvsc_file_stamp_equal(const hvsc_file_stamp_t *s1,
+                                  const hvsc_file_stamp_t *s2);
+void        hvsc_index_init(hvsc_index_t *index, size_t keylen);
+void        hvsc_index_add(hvsc_index_t *index, const char *key,
+                           long offset, long lineno);
+void        hvsc_index_sort(hvsc_index_t *index);
+const hvsc_index_entry_t *hvsc_index_find(const hvsc_index_t *index,
+                                          const char *key);
+void        hvsc_index_free(hvsc_index_t *index);
 
 char *      hvsc_path_strip_root(const char *path);
 void        hvsc_path_fix_separators(char *path);
@@ -97,6 +97,8 @@ bool hvsc_init(const char *path)
  */
 void hvsc_exit(void)
 {
+    hvsc_sldb_index_free();
+    hvsc_stil_index_free();
     hvsc_free_paths();
 }
 
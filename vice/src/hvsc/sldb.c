@@ -92,6 +92,108 @@ static bool create_md5_hash(const char *psid, unsigned char *digest)
 #endif
 
 
+/** \brief  Index of the SLDB
+ *
+ * Built from the SLDB on the first lookup, so looking up a SID doesn't scan
+ * the whole file each time. Rebuilt when the SLDB path, size or modification
+ * time changes.
+ */
+static struct {
+    char *              path;       /**< path of the indexed SLDB */
+    hvsc_file_stamp_t   stamp;      /**< size and mtime of the indexed SLDB */
+    char *              text;       /**< contents of the SLDB, split in lines */
+    hvsc_index_t        paths;      /**< entries keyed on "; /path" comments */
+#ifdef HVSC_USE_MD5
+    hvsc_index_t        digests;    /**< entries keyed on MD5 digest */
+#endif
+} sldb_index;
+
+
+/** \brief  Free memory used by the SLDB index
+ */
+void hvsc_sldb_index_free(void)
+{
+    hvsc_free(sldb_index.path);
+    sldb_index.path = NULL;
+    hvsc_free(sldb_index.text);
+    sldb_index.text = NULL;
+    hvsc_index_free(&(sldb_index.paths));
+#ifdef HVSC_USE_MD5
+    hvsc_index_free(&(sldb_index.digests));
+#endif
+}
+
+
+/** \brief  Make sure the SLDB index is up to date with the SLDB
+ *
+ * \return  bool
+ */
+static bool sldb_index_update(void)
+{
+    hvsc_file_stamp_t stamp;
+    uint8_t *data;
+    long size;
+    char *pos;
+    char *end;
+    char *line;
+    char *comment = NULL;
+
+    if (!hvsc_file_get_stamp(hvsc_sldb_path, &stamp)) {
+        return false;
+    }
+    if (sldb_index.text != NULL
+            && strcmp(sldb_index.path, hvsc_sldb_path) == 0
+            && hvsc_file_stamp_equal(&(sldb_index.stamp), &stamp)) {
+        return true;
+    }
+
+    hvsc_sldb_index_free();
+#ifndef HVSC_STANDALONE
+    log_message(LOG_DEFAULT, "Vsid: Indexing '%s'.", hvsc_sldb_path);
+#endif
+    size = hvsc_read_file(&data, hvsc_sldb_path);
+    if (size < 0) {
+        return false;
+    }
+    sldb_index.text = hvsc_realloc(data, (size_t)size + 1);
+    sldb_index.text[size] = '\0';
+    sldb_index.path = hvsc_strdup(hvsc_sldb_path);
+    sldb_index.stamp = stamp;
+    hvsc_index_init(&(sldb_index.paths), 0);
+#ifdef HVSC_USE_MD5
+    hvsc_index_init(&(sldb_index.digests), HVSC_DIGEST_SIZE * 2);
+#endif
+
+    pos = sldb_index.text;
+    end = sldb_index.text + size;
+    while ((line = hvsc_text_next_line(&pos, end)) != NULL) {
+        long offset = (long)(line - sldb_index.text);
+
+        if (*line == ';') {
+            /* "; /path/to/file": the next line contains the actual entry */
+            comment = line[1] == ' ' ? line + 2 : NULL;
+            continue;
+        }
+        if (comment != NULL) {
+            hvsc_index_add(&(sldb_index.paths), comment, offset, 0);
+            comment = NULL;
+        }
+#ifdef HVSC_USE_MD5
+        if (strlen(line) > HVSC_DIGEST_SIZE * 2) {
+            hvsc_index_add(&(sldb_index.digests), line, offset, 0);
+        }
+#endif
+    }
+
+    hvsc_index_sort(&(sldb_index.paths));
+#ifdef HVSC_USE_MD5
+    hvsc_index_sort(&(sldb_index.digests));
+#endif
+    hvsc_dbg("indexed %zu entries\n", sldb_index.paths.count);
+    return true;
+}
+
+
 #ifdef HVSC_USE_MD5
 /** \brief  Find SLDB entry by \a digest
  *
@@ -104,33 +206,17 @@ static bool create_md5_hash(const char *psid, unsigned char *digest)
  */
 static char *find_sldb_entry_md5(const char *digest)
 {
-    hvsc_text_file_t handle;
-    const char *line;
+    const hvsc_index_entry_t *entry;
 
-    if (!hvsc_text_file_open(hvsc_sldb_path, &handle)) {
+    if (!sldb_index_update()) {
         return NULL;
     }
 
-    while (1) {
-        line = hvsc_text_file_read(&handle);
-        if (line == NULL) {
-            hvsc_text_file_close(&handle);
-            return NULL;
-        }
-#if 0
-        printf("%s\n", line);
-#endif
-        if (memcmp(digest, line, HVSC_DIGEST_SIZE * 2) == 0) {
-            /* copy the current line before closing the file */
-            char *s = hvsc_strdup(handle.buffer);
-            hvsc_text_file_close(&handle);
-            return s;
-        }
+    entry = hvsc_index_find(&(sldb_index.digests), digest);
+    if (entry == NULL) {
+        return NULL;
     }
-
-    hvsc_text_file_close(&handle);
-    hvsc_errno = HVSC_ERR_NOT_FOUND;
-    return NULL;
+    return hvsc_strdup(sldb_index.text + entry->offset);
 }
 #endif
 
@@ -143,54 +229,24 @@ static char *find_sldb_entry_md5(const char *digest)
  */
 static char *find_sldb_entry_txt(const char *path)
 {
-    hvsc_text_file_t handle;
-    size_t plen;
-    const char *line;
-#ifndef HVSC_STANDALONE
-    log_message(LOG_DEFAULT, "Vsid: Opening '%s'.", hvsc_sldb_path);
-#endif
-    if (!hvsc_text_file_open(hvsc_sldb_path, &handle)) {
+    const hvsc_index_entry_t *entry;
+
+    if (!sldb_index_update()) {
 #ifndef HVSC_STANDALONE
         log_warning(LOG_DEFAULT, "Vsid: Failed to open the SLDB.");
 #endif
         return NULL;
     }
 
-    plen = strlen(path);
-
-    while (true) {
-        line = hvsc_text_file_read(&handle);
-        if (line == NULL) {
-            hvsc_text_file_close(&handle);
+    entry = hvsc_index_find(&(sldb_index.paths), path);
+    if (entry == NULL) {
 #ifndef HVSC_STANDALONE
-            log_warning(LOG_DEFAULT,
-                    "Vsid: Could not find song length data for current SID.");
+        log_warning(LOG_DEFAULT,
+                "Vsid: Could not find song length data for current SID.");
 #endif
-            return NULL;
-        }
-
-
-        if (*line == ';') {
-            if (strncmp(path, line + 2, plen) == 0) {
-                /* next line contains the actual entry */
-                char *s;
-                line = hvsc_text_file_read(&handle);
-                if (line == NULL) {
-                    hvsc_text_file_close(&handle);
-                    return NULL;
-                }
-                s = hvsc_strdup(handle.buffer);
-                hvsc_text_file_close(&handle);
-                return s;
-            }
-        }
+        return NULL;
     }
-
-#if 0 /* above loop never breaks - following code can never execute */
-    hvsc_text_file_close(&handle);
-    hvsc_errno = HVSC_ERR_NOT_FOUND;
-    return NULL;
-#endif
+    return hvsc_strdup(sldb_index.text + entry->offset);
 }
 
 
@@ -26,5 +26,6 @@
 #ifndef HVSC_SLDB_H
 #define HVSC_SLDB_H
 
+void hvsc_sldb_index_free(void);
 
 #endif
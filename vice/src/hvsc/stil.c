@@ -426,6 +426,102 @@ static void stil_handle_add_block(hvsc_stil_t *handle, hvsc_stil_block_t *block)
 }
 
 
+/** \brief  Index of the STIL
+ *
+ * Maps the paths of the STIL entries to their offset and line number in the
+ * file, so opening an entry doesn't require scanning the file up to the
+ * entry. Built on the first lookup and rebuilt when the STIL path, size or
+ * modification time changes.
+ */
+static struct {
+    char *              path;   /**< path of the indexed STIL */
+    hvsc_file_stamp_t   stamp;  /**< size and mtime of the indexed STIL */
+    char *              keys;   /**< entry paths, nul-terminated */
+    hvsc_index_t        index;  /**< entries keyed on path */
+} stil_index;
+
+
+/** \brief  Free memory used by the STIL index
+ */
+void hvsc_stil_index_free(void)
+{
+    hvsc_free(stil_index.path);
+    stil_index.path = NULL;
+    hvsc_free(stil_index.keys);
+    stil_index.keys = NULL;
+    hvsc_index_free(&(stil_index.index));
+}
+
+
+/** \brief  Make sure the STIL index is up to date with the STIL
+ *
+ * \return  bool
+ */
+static bool stil_index_update(void)
+{
+    hvsc_file_stamp_t stamp;
+    uint8_t *data;
+    long size;
+    char *text;
+    char *pos;
+    char *end;
+    char *line;
+    size_t keys_size = 0;
+    long lineno = 0;
+    size_t i;
+
+    if (!hvsc_file_get_stamp(hvsc_stil_path, &stamp)) {
+        return false;
+    }
+    if (stil_index.keys != NULL
+            && strcmp(stil_index.path, hvsc_stil_path) == 0
+            && hvsc_file_stamp_equal(&(stil_index.stamp), &stamp)) {
+        return true;
+    }
+
+    hvsc_stil_index_free();
+#ifndef HVSC_STANDALONE
+    log_message(LOG_DEFAULT, "Vsid: Indexing '%s'.", hvsc_stil_path);
+#endif
+    size = hvsc_read_file(&data, hvsc_stil_path);
+    if (size < 0) {
+        return false;
+    }
+    text = hvsc_realloc(data, (size_t)size + 1);
+    hvsc_index_init(&(stil_index.index), 0);
+
+    /* move the entry paths to the start of the text while indexing */
+    pos = text;
+    end = text + size;
+    while ((line = hvsc_text_next_line(&pos, end)) != NULL) {
+        lineno++;
+        if (*line == '/') {
+            size_t len = strlen(line) + 1;
+
+            hvsc_index_add(&(stil_index.index), text + keys_size,
+                           (long)(line - text), lineno);
+            memmove(text + keys_size, line, len);
+            keys_size += len;
+        }
+    }
+
+    /* copy the paths, so the rest of the text can be freed */
+    stil_index.keys = hvsc_malloc(keys_size + 1);
+    memcpy(stil_index.keys, text, keys_size);
+    for (i = 0; i < stil_index.index.count; i++) {
+        hvsc_index_entry_t *entry = &(stil_index.index.entries[i]);
+        entry->key = stil_index.keys + (entry->key - text);
+    }
+    hvsc_free(text);
+
+    hvsc_index_sort(&(stil_index.index));
+    stil_index.path = hvsc_strdup(hvsc_stil_path);
+    stil_index.stamp = stamp;
+    hvsc_dbg("indexed %zu entries\n", stil_index.index.count);
+    return true;
+}
+
+
 /** \brief  Open STIL and look for PSID file \a psid
  *
  * \param[in]       psid    path to PSID file
@@ -436,6 +532,7 @@ static void stil_handle_add_block(hvsc_stil_t *handle, hvsc_stil_block_t *block)
 bool hvsc_stil_open(const char *psid, hvsc_stil_t *handle)
 {
     const char *line;
+    const hvsc_index_entry_t *entry;
 
     stil_init_handle(handle);
 
@@ -463,6 +560,32 @@ bool hvsc_stil_open(const char *psid, hvsc_stil_t *handle)
 #endif
     hvsc_dbg("stripped path is '%s'\n", handle->psid_path);
 
+    /* look up the entry in the index and seek to it */
+    if (stil_index_update()) {
+        entry = hvsc_index_find(&(stil_index.index), handle->psid_path);
+        if (entry == NULL) {
+#ifndef HVSC_STANDALONE
+            log_message(LOG_DEFAULT, "Vsid: No STIL entry found.");
+#endif
+            hvsc_stil_close(handle);
+            return false;
+        }
+        if (fseek(handle->stil.fp, entry->offset, SEEK_SET) == 0) {
+            line = hvsc_text_file_read(&(handle->stil));
+            if (line != NULL && strcmp(line, handle->psid_path) == 0) {
+                handle->stil.lineno = entry->lineno;
+#ifndef HVSC_STANDALONE
+                log_message(LOG_DEFAULT,
+                        "Vsid: Found '%s' at line %ld.", line, entry->lineno);
+#endif
+                return true;
+            }
+        }
+        /* index out of sync with the file, fall back to scanning it */
+        rewind(handle->stil.fp);
+        handle->stil.lineno = 0;
+    }
+
     /* find the entry */
     while (true) {
         line = hvsc_text_file_read(&(handle->stil));
@@ -28,4 +28,6 @@
 
 #include "hvsc_defs.h"
 
+void hvsc_stil_index_free(void);
+
 #endif
@@ -48,10 +48,12 @@
 #include "palette.h"
 #include "ram.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "signals.h"
 #include "sysfile.h"
+#include "testbatch.h"
 #include "uiapi.h"
 #include "vdrive.h"
 #include "video.h"
@@ -128,6 +130,10 @@ int init_resources(void)
         init_resource_fail("monitor");
         return -1;
     }
+    if (rewind_resources_init() < 0) {
+        init_resource_fail("rewind");
+        return -1;
+    }
 #ifdef HAVE_NETWORK
     if (monitor_network_resources_init() < 0) {
         init_resource_fail("MONITOR_NETWORK");
@@ -209,6 +215,14 @@ int init_cmdline_options(void)
             init_cmdline_options_fail("RAM");
             return -1;
         }
+        if (rewind_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("rewind");
+            return -1;
+        }
+        if (testbatch_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("test batch");
+            return -1;
+        }
     }
 #ifdef HAVE_NETWORK
     if (monitor_network_cmdline_options_init() < 0) {
@@ -62,11 +62,14 @@
 #include "printer.h"
 #include "profiler.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
+#include "snapshot.h"
 #include "sound.h"
 #include "sysfile.h"
 #include "tape.h"
+#include "testbatch.h"
 #include "traps.h"
 #include "types.h"
 #include "uiapi.h"
@@ -337,6 +340,9 @@ void machine_shutdown(void)
     screenshot_at_exit();
     screenshot_shutdown();
 
+    rewind_shutdown();
+    testbatch_shutdown();
+
     file_system_detach_disk_shutdown();
 
     machine_specific_shutdown();
@@ -423,6 +429,33 @@ void machine_shutdown(void)
     archdep_shutdown();
 }
 
+/* --------------------------------------------------------- */
+/* In-memory snapshots */
+
+/* Write a snapshot of the whole machine into `mem' instead of a file.  */
+int machine_write_snapshot_memory(snapshot_memory_t *mem, int save_roms, int save_disks, int event_mode)
+{
+    int result;
+
+    snapshot_memory_select(mem);
+    result = machine_write_snapshot("", save_roms, save_disks, event_mode);
+    snapshot_memory_select(NULL);
+
+    return result;
+}
+
+/* Restore the machine state from the snapshot held in `mem'.  */
+int machine_read_snapshot_memory(snapshot_memory_t *mem, int event_mode)
+{
+    int result;
+
+    snapshot_memory_select(mem);
+    result = machine_read_snapshot("", event_mode);
+    snapshot_memory_select(NULL);
+
+    return result;
+}
+
 /* --------------------------------------------------------- */
 /* Resources & cmdline */
 
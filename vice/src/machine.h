@@ -143,6 +143,11 @@ int machine_write_snapshot(const char *name, int save_roms, int save_disks, int
 /* Read a snapshot.  */
 int machine_read_snapshot(const char *name, int even_mode);
 
+/* Write/read a snapshot to/from a memory buffer instead of a file.  */
+struct snapshot_memory_s;
+int machine_write_snapshot_memory(struct snapshot_memory_s *mem, int save_roms, int save_disks, int event_mode);
+int machine_read_snapshot_memory(struct snapshot_memory_s *mem, int event_mode);
+
 /* handle pending interrupts - needed by libsid.a.  */
 void machine_handle_pending_alarms(CLOCK num_write_cycles);
 
@@ -34,6 +34,7 @@
 #include "alarm.h"
 #include "archdep.h"
 #include "autostart.h"
+#include "c64mem.h"
 
 #ifdef FEATURE_CPUMEMHISTORY
 #include "c64pla.h"
@@ -251,7 +252,7 @@ inline static void memmap_mem_update(unsigned int addr, int write)
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1);
-    (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
+    mem_store_ram_or_tab(addr, (uint8_t)(value));
 }
 
 static void memmap_mem_store_dummy(unsigned int addr, unsigned int value)
@@ -265,7 +266,7 @@ static uint8_t memmap_mem_read(unsigned int addr)
 {
     check_ba();
     memmap_mem_update(addr, 0);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    return mem_read_ram_or_tab(addr);
 }
 
 static uint8_t memmap_mem_read_dummy(unsigned int addr)
@@ -349,7 +350,7 @@ static uint8_t memmap_mem_read_dummy(unsigned int addr)
 inline static uint8_t mem_read_check_ba(unsigned int addr)
 {
     check_ba();
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    return mem_read_ram_or_tab(addr);
 }
 
 inline static uint8_t mem_read_check_ba_dummy(unsigned int addr)
@@ -361,7 +362,7 @@ inline static uint8_t mem_read_check_ba_dummy(unsigned int addr)
 #ifndef STORE
 #define STORE(addr, value) \
     if (reu_dma_triggered == 0) { \
-        (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value)); \
+        mem_store_ram_or_tab(addr, (uint8_t)(value)); \
         if (addr == 0xff00) { \
             reu_dma(-1); \
         } \
@@ -424,7 +425,7 @@ inline static uint8_t mem_read_check_ba_dummy(unsigned int addr)
 /* Route stack operations through read/write handlers */
 
 #ifndef PUSH
-#define PUSH(val) (*_mem_write_tab_ptr[0x01])((uint16_t)(0x100 + (reg_sp--)), (uint8_t)(val))
+#define PUSH(val) mem_store_ram_or_tab(0x100 + (reg_sp--), (uint8_t)(val))
 #endif
 
 #ifndef PULL
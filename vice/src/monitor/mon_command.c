@@ -145,11 +145,13 @@ static const mon_cmds_t mon_cmd_array[] = {
     },
 
     { "profile", "prof",
-      "[on|off]|[flat [num]]|[graph [context] [depth]]|[func <function>]",
+      "[on|off]|[sample [cycles]]|[flat [num]]|[graph [context] [depth]]|[func <function>]",
       "Main CPU profiling functions. Commands:\n"
       "\n"
       "    prof on                        Start profiling and flush old profiling\n"
       "                                   data.\n"
+      "    prof sample [<cycles=1000>]    Start sampling the PC and call stack\n"
+      "                                   every 'cycles' cycles instead.\n"
       "    prof off                       Stop profiling.\n"
       "    prof flat [<num=20>]           Show flat summary of 'num' top functions\n"
       "                                   sorted by self time.\n"
@@ -161,7 +163,17 @@ static const mon_cmds_t mon_cmd_array[] = {
       "    prof context <ctx>             Detailed context information including\n"
       "                                   per-instruction profiling for function\n"
       "                                   in a call graph context.\n"
-      "    prof clear <function>          Clears all profiling stats for function.\n",
+      "    prof clear <function>          Clears all profiling stats for function.\n"
+      "    prof export \"<file>\"           Save call stacks in collapsed stack\n"
+      "                                   format for flame graph tools.\n",
+      NO_FILENAME_ARG
+    },
+
+    { "rastercache", "rc",
+      "[reset]",
+      "Show how many lines of the last frame and of all frames since the last\n"
+      "reset were taken from the raster cache, redrawn, or drawn with mid-line\n"
+      "changes, and how often the sprite cache matched. 'reset' clears the totals.",
       NO_FILENAME_ARG
     },
 
@@ -200,7 +212,9 @@ static const mon_cmds_t mon_cmd_array[] = {
 
     { "stopwatch", "sw",
       NULL,
-      "Print the CPU cycle counter of the current device. 'reset' sets the counter to 0.",
+      "Print the CPU cycle counter of the current device. 'reset' sets the counter to 0.\n"
+      "For drives, also print how many of these cycles were skipped while the\n"
+      "drive was idling.",
       NO_FILENAME_ARG
     },
 
@@ -145,9 +145,11 @@ int yylex(void);
 %token CMD_ATTACH CMD_DETACH CMD_MON_RESET CMD_TAPECTRL CMD_CARTFREEZE CMD_UPDB CMD_JPDB
 %token CMD_CPUHISTORY CMD_MEMMAPZAP CMD_MEMMAPSHOW CMD_MEMMAPSAVE
 %token CMD_COMMENT CMD_LIST CMD_STOPWATCH RESET
+%token CMD_RASTER_CACHE
 %token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE
 %token CMD_WARP
 %token CMD_PROFILE FLAT GRAPH FUNC DEPTH DISASS PROFILE_CONTEXT CLEAR
+%token PROFILE_SAMPLE PROFILE_EXPORT
 %token<str> CMD_LABEL_ASGN
 %token<i> L_PAREN R_PAREN ARG_IMMEDIATE REG_A REG_X REG_Y COMMA INST_SEP
 %token<i> L_BRACKET R_BRACKET LESS_THAN REG_U REG_S REG_PC REG_PCR
@@ -588,11 +590,20 @@ monitor_misc_rules: CMD_DISK rest_of_line end_cmd
                   | CMD_STOPWATCH RESET end_cmd
                      { mon_stopwatch_reset(); }
                   | CMD_STOPWATCH end_cmd
-                     { mon_stopwatch_show("Stopwatch: ", "\n"); }
+                     { mon_stopwatch_show("Stopwatch: ", "\n");
+                       mon_stopwatch_show_idle(); }
+                  | CMD_RASTER_CACHE RESET end_cmd
+                     { mon_raster_cache_stats(1); }
+                  | CMD_RASTER_CACHE end_cmd
+                     { mon_raster_cache_stats(0); }
                   | CMD_PROFILE TOGGLE end_cmd
                      { mon_profile_action($2); }
                   | CMD_PROFILE end_cmd
                      { mon_profile(); }
+                  | CMD_PROFILE PROFILE_SAMPLE opt_d_number end_cmd
+                     { mon_profile_sample($3); }
+                  | CMD_PROFILE PROFILE_EXPORT STRING end_cmd
+                     { mon_profile_export($3); }
                   | CMD_PROFILE FLAT opt_d_number end_cmd
                      { mon_profile_flat($3); }
                   | CMD_PROFILE GRAPH opt_context_num end_cmd
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "lib.h"
 #include "machine.h"
 #include "maincpu.h"
@@ -56,7 +57,9 @@ static bool is_merged(profiling_context_t *context) {
 
 void mon_profile(void)
 {
-    if (maincpu_profiling) {
+    if (profile_is_sampling()) {
+        mon_out("Sampling profiler running.\n");
+    } else if (profile_is_running()) {
         mon_out("Profiling running.\n");
     } else if (!root_context) {
         mon_out("Profiling not started.\n");
@@ -70,7 +73,7 @@ void mon_profile_action(ACTION action)
 {
     switch(action) {
     case e_OFF: {
-        if (maincpu_profiling) {
+        if (profile_is_running()) {
             profile_stop();
             mon_out("Profiling stopped.\n");
         } else {
@@ -79,8 +82,10 @@ void mon_profile_action(ACTION action)
         return;
     }
     case e_ON: {
+        bool running = profile_is_running();
+
         profile_start();
-        if (maincpu_profiling) {
+        if (running) {
             mon_out("Profiling restarted.\n");
         } else {
             mon_out("Profiling started.\n");
@@ -88,7 +93,7 @@ void mon_profile_action(ACTION action)
         return;
     }
     case e_TOGGLE: {
-        if (maincpu_profiling) {
+        if (profile_is_running()) {
             mon_profile_action(e_OFF);
         } else {
             mon_profile_action(e_ON);
@@ -98,6 +103,19 @@ void mon_profile_action(ACTION action)
     }
 }
 
+void mon_profile_sample(int interval)
+{
+    if (interval < 0) {
+        interval = 1000;
+    } else if (interval == 0) {
+        mon_out("Sampling interval must be at least one cycle.\n");
+        return;
+    }
+
+    profile_start_sampling((unsigned int)interval);
+    mon_out("Sampling profiler started, one sample every %d cycles.\n", interval);
+}
+
 static bool init_profiling_data(void) {
     if (!root_context) {
         mon_out("No profiling data available. Start profiling with \"prof on\".\n");
@@ -1139,3 +1157,72 @@ void mon_profile_clear(MON_ADDR function)
     clear_recursively(root_context, addr);
 }
 
+
+/* name of a call stack frame, as print_src() and print_dst() show it */
+static char *frame_name(profiling_context_t *context)
+{
+    char *name = mon_symbol_table_lookup_name(default_memspace, context->pc_dst);
+    const char *src = "";
+
+    switch (context->pc_src) {
+    case 0xfffa: src = "NMI "; break;
+    case 0xfffc: src = "RST "; break;
+    case 0xfffe: src = "IRQ "; break;
+    }
+
+    if (name) {
+        return lib_msprintf("%s%s", src, name);
+    }
+    return lib_msprintf("%s%04x", src, (unsigned)context->pc_dst);
+}
+
+static int export_context(FILE *fp, profiling_context_t *context, const char *stack)
+{
+    char *frames = NULL;
+    int lines = 0;
+
+    if (context != root_context) {
+        char *name = frame_name(context);
+
+        frames = stack ? lib_msprintf("%s;%s", stack, name) : lib_strdup(name);
+        lib_free(name);
+
+        if (context->total_cycles_self) {
+            fprintf(fp, "%s %u\n", frames, context->total_cycles_self);
+            lines++;
+        }
+    }
+
+    if (context->child) {
+        profiling_context_t *c = context->child;
+        do {
+            lines += export_context(fp, c, frames);
+            c = c->next;
+        } while (c != context->child);
+    }
+
+    lib_free(frames);
+    return lines;
+}
+
+/* Write the call graph in the "collapsed stack" format read by flame graph
+   tools: one line per call stack, frames separated by ';', followed by the
+   number of cycles spent in the innermost frame. */
+void mon_profile_export(const char *filename)
+{
+    FILE *fp;
+    int lines;
+
+    if (!init_profiling_data()) return;
+
+    fp = fopen(filename, MODE_WRITE_TEXT);
+    if (fp == NULL) {
+        mon_out("Cannot open %s.\n", filename);
+        return;
+    }
+
+    lines = export_context(fp, root_context, NULL);
+    fclose(fp);
+
+    mon_out("Wrote %d call stacks to %s.\n", lines, filename);
+}
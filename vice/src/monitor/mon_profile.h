@@ -31,6 +31,8 @@
 /* monitor commands */
 void mon_profile(void);
 void mon_profile_action(ACTION action); /* on|off|toggle */
+void mon_profile_sample(int interval);
+void mon_profile_export(const char *filename);
 void mon_profile_flat(int num);
 void mon_profile_graph(int context_id, int depth);
 void mon_profile_func(MON_ADDR function);
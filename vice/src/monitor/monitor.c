@@ -80,6 +80,7 @@
 #include "joyport_io_sim.h"
 #include "joyport.h"
 
+#include "raster.h"
 #include "resources.h"
 #include "screenshot.h"
 #include "sysfile.h"
@@ -187,6 +188,7 @@ static unsigned int watch_load_count[NUM_MEMSPACES];
 static unsigned int watch_store_count[NUM_MEMSPACES];
 static symbol_table_t monitor_labels[NUM_MEMSPACES];
 static CLOCK stopwatch_start_time[NUM_MEMSPACES];
+static CLOCK stopwatch_start_idle[NUM_MEMSPACES];
 bool force_array[NUM_MEMSPACES];
 monitor_interface_t *mon_interfaces[NUM_MEMSPACES];
 
@@ -1429,14 +1431,75 @@ void mon_stopwatch_show(const char* prefix, const char* suffix)
     mon_out("%s%10lu%s", prefix, t, suffix);
 }
 
+/* For drives, also show how many of the cycles were skipped by the
+   `trap idle' method.  */
+void mon_stopwatch_show_idle(void)
+{
+    int dnr = monitor_diskspace_dnr(default_memspace);
+
+    if (dnr >= 0) {
+        mon_out("Idle:      %10lu\n",
+                (unsigned long)(drive_cpu_get_idle_skipped_cycles((unsigned int)dnr)
+                                - stopwatch_start_idle[default_memspace]));
+    }
+}
+
 void mon_stopwatch_reset(void)
 {
     monitor_interface_t* vice_interface;
+    int dnr = monitor_diskspace_dnr(default_memspace);
+
     vice_interface = mon_interfaces[default_memspace];
     stopwatch_start_time[default_memspace] = *vice_interface->clk;
+    if (dnr >= 0) {
+        stopwatch_start_idle[default_memspace] =
+            drive_cpu_get_idle_skipped_cycles((unsigned int)dnr);
+    }
     mon_out("Stopwatch reset to 0.\n");
 }
 
+static void mon_raster_cache_stats_line(const char *prefix,
+                                        const raster_cache_stats_t *stats)
+{
+    unsigned long lines;
+
+    lines = (unsigned long)stats->lines_cached + stats->lines_redrawn
+            + stats->lines_changes;
+
+    mon_out("%s%10u cached %10u redrawn %10u changes %10u sprite hits",
+            prefix, stats->lines_cached, stats->lines_redrawn,
+            stats->lines_changes, stats->sprite_cache_hits);
+    if (lines > 0) {
+        mon_out(" (%lu%% cached)", (unsigned long)stats->lines_cached * 100 / lines);
+    }
+    mon_out("\n");
+}
+
+void mon_raster_cache_stats(int reset)
+{
+    const char *name;
+    const raster_cache_stats_t *frame, *total;
+    unsigned int index, frames;
+
+    if (reset) {
+        raster_cache_stats_reset();
+        mon_out("Raster cache statistics reset.\n");
+        return;
+    }
+
+    for (index = 0;
+         raster_cache_stats_get(index, &name, &frame, &total, &frames) == 0;
+         index++) {
+        mon_out("%s: %u frames\n", name, frames);
+        mon_raster_cache_stats_line("  Last frame: ", frame);
+        mon_raster_cache_stats_line("  Total:      ", total);
+    }
+
+    if (index == 0) {
+        mon_out("No active raster.\n");
+    }
+}
+
 /* Local helper functions for building the lists */
 static monitor_cpu_type_t* find_monitor_cpu_type(CPU_TYPE_t cputype)
 {
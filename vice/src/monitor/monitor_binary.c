@@ -49,6 +49,7 @@
 #include "screenshot.h"
 #include "machine-video.h"
 #include "palette.h"
+#include "raster.h"
 
 #include "mon_breakpoint.h"
 #include "mon_file.h"
@@ -75,6 +76,7 @@ enum t_binary_command {
 
     e_MON_CMD_MEM_GET = 0x01,
     e_MON_CMD_MEM_SET = 0x02,
+    e_MON_CMD_MEM_DIFF = 0x03,
 
     e_MON_CMD_CHECKPOINT_GET = 0x11,
     e_MON_CMD_CHECKPOINT_SET = 0x12,
@@ -102,6 +104,8 @@ enum t_binary_command {
     e_MON_CMD_REGISTERS_AVAILABLE = 0x83,
     e_MON_CMD_DISPLAY_GET = 0x84,
     e_MON_CMD_VICE_INFO = 0x85,
+    e_MON_CMD_BATCH = 0x86,
+    e_MON_CMD_RASTER_CACHE_STATS = 0x87,
 
     e_MON_CMD_PALETTE_GET = 0x91,
 
@@ -120,6 +124,7 @@ enum t_binary_response {
     e_MON_RESPONSE_INVALID = 0x00,
     e_MON_RESPONSE_MEM_GET = 0x01,
     e_MON_RESPONSE_MEM_SET = 0x02,
+    e_MON_RESPONSE_MEM_DIFF = 0x03,
 
     e_MON_RESPONSE_CHECKPOINT_INFO = 0x11,
 
@@ -150,6 +155,8 @@ enum t_binary_response {
     e_MON_RESPONSE_REGISTERS_AVAILABLE = 0x83,
     e_MON_RESPONSE_DISPLAY_GET = 0x84,
     e_MON_RESPONSE_VICE_INFO = 0x85,
+    e_MON_RESPONSE_BATCH = 0x86,
+    e_MON_RESPONSE_RASTER_CACHE_STATS = 0x87,
 
     e_MON_RESPONSE_PALETTE_GET = 0x91,
 
@@ -196,6 +203,62 @@ struct binary_command_s {
 };
 typedef struct binary_command_s binary_command_t;
 
+/* Number of 256 byte pages tracked by MON_CMD_MEM_DIFF */
+#define MEM_DIFF_PAGES 256
+
+/* Memory contents as last reported by MON_CMD_MEM_DIFF, per memspace and bank */
+struct mem_diff_shadow_s {
+    MEMSPACE memspace;
+    int bank;
+    uint8_t *data;      /* copy of the 64K address space */
+    uint8_t *valid;     /* non-zero for each byte that has been reported */
+    struct mem_diff_shadow_s *next;
+};
+typedef struct mem_diff_shadow_s mem_diff_shadow_t;
+
+static mem_diff_shadow_t *mem_diff_shadows = NULL;
+
+/* Responses are assembled here. While a batch is processed, they are
+   collected behind the header of the batch response and sent in one go. */
+static unsigned char *response_buffer = NULL;
+static size_t response_buffer_size = 0;
+static size_t response_buffer_length = 0;
+static bool batch_active = false;
+
+static void mem_diff_reset(void)
+{
+    while (mem_diff_shadows != NULL) {
+        mem_diff_shadow_t *next = mem_diff_shadows->next;
+
+        lib_free(mem_diff_shadows->data);
+        lib_free(mem_diff_shadows->valid);
+        lib_free(mem_diff_shadows);
+        mem_diff_shadows = next;
+    }
+}
+
+/* Find the shadow copy of a memspace and bank, creating an empty one */
+static mem_diff_shadow_t *mem_diff_get_shadow(MEMSPACE memspace, int bank)
+{
+    mem_diff_shadow_t *shadow;
+
+    for (shadow = mem_diff_shadows; shadow != NULL; shadow = shadow->next) {
+        if (shadow->memspace == memspace && shadow->bank == bank) {
+            return shadow;
+        }
+    }
+
+    shadow = lib_malloc(sizeof(mem_diff_shadow_t));
+    shadow->memspace = memspace;
+    shadow->bank = bank;
+    shadow->data = lib_malloc(0x10000);
+    shadow->valid = lib_calloc(1, 0x10000);
+    shadow->next = mem_diff_shadows;
+    mem_diff_shadows = shadow;
+
+    return shadow;
+}
+
 int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
 {
     int error = 0;
@@ -258,6 +321,8 @@ static int monitor_binary_data_available(void)
 
         if (vice_network_select_poll_one(listen_socket)) {
             connected_socket = vice_network_accept(listen_socket);
+            /* a new client has not seen any memory yet */
+            mem_diff_reset();
         }
     }
 
@@ -314,21 +379,50 @@ static uint16_t little_endian_to_uint16(unsigned char *input) {
     return (input[1] << 8) + input[0];
 }
 
-static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode, uint32_t request_id, unsigned char *body)
+/*! \internal \brief Make room for \a length more bytes in the response buffer
+    and return a pointer to them */
+static unsigned char *response_buffer_reserve(size_t length)
 {
-    unsigned char response[12];
+    unsigned char *output;
 
-    response[0] = ASC_STX;
-    response[1] = MON_BINARY_API_VERSION;
-    write_uint32(length, &response[2]);
-    response[6] = (uint8_t)response_type;
-    response[7] = (uint8_t)errorcode;
-    write_uint32(request_id, &response[8]);
+    if (response_buffer_length + length > response_buffer_size) {
+        response_buffer_size = response_buffer_length + length + 0x1000;
+        response_buffer = lib_realloc(response_buffer, response_buffer_size);
+    }
+
+    output = response_buffer + response_buffer_length;
+    response_buffer_length += length;
+
+    return output;
+}
+
+/*! \internal \brief Write a response header to \a output */
+static void write_response_header(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode, uint32_t request_id, unsigned char *output)
+{
+    output[0] = ASC_STX;
+    output[1] = MON_BINARY_API_VERSION;
+    write_uint32(length, &output[2]);
+    output[6] = (uint8_t)response_type;
+    output[7] = (uint8_t)errorcode;
+    write_uint32(request_id, &output[8]);
+}
 
-    monitor_binary_transmit(response, sizeof response);
+static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode, uint32_t request_id, unsigned char *body)
+{
+    unsigned char *response;
+
+    /* header and body go out in one piece, so they don't end up in
+       separate TCP segments */
+    response = response_buffer_reserve(12 + (body != NULL ? length : 0));
+    write_response_header(length, response_type, errorcode, request_id, response);
 
     if (body != NULL) {
-        monitor_binary_transmit(body, length);
+        memcpy(response + 12, body, length);
+    }
+
+    if (!batch_active) {
+        monitor_binary_transmit(response_buffer, response_buffer_length);
+        response_buffer_length = 0;
     }
 }
 
@@ -1403,6 +1497,66 @@ static void monitor_binary_process_vice_info(binary_command_t *command)
     monitor_binary_response(sizeof(response), e_MON_RESPONSE_VICE_INFO, e_MON_ERR_OK, command->request_id, response);
 }
 
+static unsigned char *write_raster_cache_stats(const raster_cache_stats_t *stats, unsigned char *output)
+{
+    output = write_uint32(stats->lines_cached, output);
+    output = write_uint32(stats->lines_redrawn, output);
+    output = write_uint32(stats->lines_changes, output);
+    output = write_uint32(stats->sprite_cache_hits, output);
+
+    return output;
+}
+
+static void monitor_binary_process_raster_cache_stats(binary_command_t *command)
+{
+    unsigned char *response;
+    unsigned char *response_cursor;
+    uint32_t response_length = 2;
+    uint16_t count;
+    const char *name;
+    const raster_cache_stats_t *frame, *total;
+    unsigned int frames;
+    size_t name_length;
+
+    if (command->length < 1) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    if (command->body[0]) {
+        raster_cache_stats_reset();
+    }
+
+    for (count = 0; raster_cache_stats_get(count, &name, &frame, &total, &frames) == 0; count++) {
+        name_length = strlen(name);
+        response_length += (uint32_t)(2 + name_length + 4 + 2 * 16);
+    }
+
+    response = lib_malloc(response_length);
+    response_cursor = write_uint16(count, response);
+
+    for (count = 0; raster_cache_stats_get(count, &name, &frame, &total, &frames) == 0; count++) {
+        name_length = strlen(name);
+
+        *response_cursor = (uint8_t)(1 + name_length + 4 + 2 * 16);
+        ++response_cursor;
+
+        *response_cursor = (uint8_t)name_length;
+        ++response_cursor;
+
+        memcpy(response_cursor, name, name_length);
+        response_cursor += name_length;
+
+        response_cursor = write_uint32(frames, response_cursor);
+        response_cursor = write_raster_cache_stats(frame, response_cursor);
+        response_cursor = write_raster_cache_stats(total, response_cursor);
+    }
+
+    monitor_binary_response(response_length, e_MON_RESPONSE_RASTER_CACHE_STATS, e_MON_ERR_OK, command->request_id, response);
+
+    lib_free(response);
+}
+
 static void monitor_binary_process_mem_get(binary_command_t *command)
 {
     unsigned char *response;
@@ -1529,6 +1683,153 @@ static void monitor_binary_process_mem_set(binary_command_t *command)
     monitor_binary_response(0, e_MON_RESPONSE_MEM_SET, e_MON_ERR_OK, command->request_id, NULL);
 }
 
+/* Pages are found by comparing the whole range with the shadow copy rather
+   than by tracking writes, as I/O registers and DMA change memory without
+   the CPU storing to it */
+static void monitor_binary_process_mem_diff(binary_command_t *command)
+{
+    unsigned char *response;
+    unsigned char *response_cursor;
+    unsigned char *current;
+    mem_diff_shadow_t *shadow;
+    uint16_t num_blocks = 0;
+    unsigned int page;
+
+    int old_sidefx = sidefx;
+    MEMSPACE memspace = e_default_space;
+
+    unsigned char *body = command->body;
+
+    uint8_t new_sidefx = body[0];
+
+    uint16_t startaddress = little_endian_to_uint16(&body[1]);
+    uint16_t endaddress = little_endian_to_uint16(&body[3]);
+
+    uint8_t requested_memspace = body[5];
+    uint16_t requested_banknum = little_endian_to_uint16(&body[6]);
+
+    uint32_t length = endaddress - startaddress + 1;
+
+    if (startaddress > endaddress) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memdiff: wrong start and/or end address %04x - %04x",
+                    startaddress, endaddress);
+        return;
+    }
+
+    if (command->length < 8) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    memspace = get_requested_memspace(requested_memspace);
+
+    if(memspace == e_invalid_space) {
+        monitor_binary_error(e_MON_ERR_INVALID_MEMSPACE, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memdiff: Unknown memspace %u", requested_memspace);
+        return;
+    }
+
+    if (mon_banknum_validate(memspace, requested_banknum) == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memdiff: Unknown bank %u", requested_banknum);
+        return;
+    }
+
+    shadow = mem_diff_get_shadow(memspace, requested_banknum);
+
+    current = lib_malloc(length);
+
+    sidefx = !!new_sidefx;
+    mon_get_mem_block_ex(memspace, requested_banknum, startaddress, endaddress - startaddress, current);
+    sidefx = old_sidefx;
+
+    /* worst case every page of the range is reported */
+    response = lib_malloc(2 + length + 4 * (MEM_DIFF_PAGES + 1));
+    response_cursor = response + 2;
+
+    for (page = startaddress >> 8; page <= (unsigned int)(endaddress >> 8); page++) {
+        unsigned int lo = page << 8;
+        unsigned int hi = lo + 0xff;
+        unsigned int block_length;
+
+        if (lo < startaddress) {
+            lo = startaddress;
+        }
+        if (hi > endaddress) {
+            hi = endaddress;
+        }
+        block_length = hi - lo + 1;
+
+        if (memchr(&shadow->valid[lo], 0, block_length) == NULL
+            && memcmp(&shadow->data[lo], &current[lo - startaddress], block_length) == 0) {
+            continue;
+        }
+
+        memcpy(&shadow->data[lo], &current[lo - startaddress], block_length);
+        memset(&shadow->valid[lo], 1, block_length);
+
+        response_cursor = write_uint16((uint16_t)lo, response_cursor);
+        response_cursor = write_uint16((uint16_t)block_length, response_cursor);
+        memcpy(response_cursor, &current[lo - startaddress], block_length);
+        response_cursor += block_length;
+
+        num_blocks++;
+    }
+
+    write_uint16(num_blocks, response);
+
+    monitor_binary_response((uint32_t)(response_cursor - response), e_MON_RESPONSE_MEM_DIFF, e_MON_ERR_OK, command->request_id, response);
+
+    lib_free(response);
+    lib_free(current);
+}
+
+static void monitor_binary_process_command(unsigned char * pbuffer);
+
+static void monitor_binary_process_batch(binary_command_t *command)
+{
+    unsigned char *body = command->body;
+    uint32_t offset = 0;
+
+    if (batch_active) {
+        /* batches don't nest */
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        return;
+    }
+
+    /* the header of the batch response is filled in at the end */
+    response_buffer_reserve(12);
+    batch_active = true;
+
+    while (offset < command->length && !exit_mon) {
+        unsigned char *sub_command = &body[offset];
+        uint32_t sub_length;
+
+        if (command->length - offset < 11 || sub_command[0] != ASC_STX) {
+            monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+            log_message(LOG_DEFAULT, "monitor binary batch: malformed command at offset %u", offset);
+            break;
+        }
+
+        sub_length = little_endian_to_uint32(&sub_command[2]);
+        if (sub_length > command->length - offset - 11) {
+            monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+            log_message(LOG_DEFAULT, "monitor binary batch: command at offset %u exceeds the batch", offset);
+            break;
+        }
+
+        monitor_binary_process_command(sub_command);
+
+        offset += 11 + sub_length;
+    }
+
+    batch_active = false;
+
+    write_response_header((uint32_t)(response_buffer_length - 12), e_MON_RESPONSE_BATCH, e_MON_ERR_OK, command->request_id, response_buffer);
+    monitor_binary_transmit(response_buffer, response_buffer_length);
+    response_buffer_length = 0;
+}
 
 static void monitor_binary_process_command(unsigned char * pbuffer)
 {
@@ -1560,6 +1861,8 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_mem_get(&command);
     } else if (command_type == e_MON_CMD_MEM_SET) {
         monitor_binary_process_mem_set(&command);
+    } else if (command_type == e_MON_CMD_MEM_DIFF) {
+        monitor_binary_process_mem_diff(&command);
 
     } else if (command_type == e_MON_CMD_CHECKPOINT_GET) {
         monitor_binary_process_checkpoint_get(&command);
@@ -1614,6 +1917,10 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_display_get(&command);
     } else if (command_type == e_MON_CMD_VICE_INFO) {
         monitor_binary_process_vice_info(&command);
+    } else if (command_type == e_MON_CMD_BATCH) {
+        monitor_binary_process_batch(&command);
+    } else if (command_type == e_MON_CMD_RASTER_CACHE_STATS) {
+        monitor_binary_process_raster_cache_stats(&command);
 
     } else if (command_type == e_MON_CMD_EXIT) {
         monitor_binary_process_exit(&command);
@@ -1859,6 +2166,11 @@ void monitor_binary_resources_shutdown(void)
     monitor_binary_deactivate();
     monitor_binary_quit();
 
+    mem_diff_reset();
+    lib_free(response_buffer);
+    response_buffer = NULL;
+    response_buffer_size = 0;
+
     lib_free(monitor_binary_server_address);
 }
 
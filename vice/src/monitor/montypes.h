@@ -334,7 +334,9 @@ void monitor_change_device(MEMSPACE mem);
 void mon_export(void);
 
 void mon_stopwatch_show(const char* prefix, const char* suffix);
+void mon_stopwatch_show_idle(void);
 void mon_stopwatch_reset(void);
+void mon_raster_cache_stats(int reset);
 void mon_maincpu_toggle_trace(int state);
 
 void mon_breakpoint_set_dummy_state(MEMSPACE mem, int state);
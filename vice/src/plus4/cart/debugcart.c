@@ -35,6 +35,7 @@
 #include "resources.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "testbatch.h"
 
 #include "debugcart.h"
 
@@ -74,6 +75,11 @@ static io_source_list_t *debugcart_list_item = NULL;
 static void debugcart_store(uint16_t addr, uint8_t value)
 {
     int n = (int)value;
+
+    if (testbatch_debugcart_exit(n)) {
+        return;
+    }
+
     fprintf(stdout, "DBGCART: exit(%d) cycles elapsed: %"PRIu64"\n", n, maincpu_clk);
     archdep_vice_exit(n);
 }
@@ -31,7 +31,9 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "lib.h"
+#include "maincpu.h"
 #include "mem.h"
 #include "profiler.h"
 #include "profiler_data.h"
@@ -65,6 +67,17 @@ int                   num_context_ids = 0;
 int                   context_id_capacity = 0;
 profiling_context_t **id_to_context = NULL;
 
+/* In sampling mode an alarm sets maincpu_profiling every sample_interval
+ * cycles, so the CPU only reports the instruction following the alarm. Each
+ * such sample stands for sample_interval cycles. The alarm can go off in the
+ * middle of an instruction (x64sc dispatches alarms per cycle), so a sample
+ * is only booked by profile_sample_finish() once profile_sample_start() has
+ * seen the start of an instruction; sample_started tracks that. */
+static bool          sampling = false;
+static bool          sample_started = false;
+static unsigned int  sample_interval = 0;
+static alarm_t      *sample_alarm = NULL;
+
 profiling_context_t  *profile_context_by_id(int id) {
     if (id > 0 && id <= num_context_ids) {
         return id_to_context[id-1];
@@ -236,8 +249,23 @@ static void initialize_context(void) {
     current_context = get_mem_config_context(current_context, mem_get_current_bank_config());
 }
 
+static void profile_sample_alarm_handler(CLOCK offset, void *data)
+{
+    alarm_set(sample_alarm, maincpu_clk - offset + sample_interval);
+
+    /* have the CPU report the next instruction */
+    maincpu_profiling = true;
+}
+
 void profile_sample_start(uint16_t pc)
 {
+    if (sampling) {
+        /* enters and exits between samples go unnoticed, don't count any */
+        exited_context = false;
+        entered_context = false;
+        sample_started = true;
+    }
+
     if (exited_context) {
         current_context->num_exits++;
         exited_context = false;
@@ -257,9 +285,24 @@ void profile_sample_start(uint16_t pc)
 
 void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles)
 {
-    profiling_data_t * data = &profiling_get_page(current_context,
-                                                 current_pc >> 8)
-                                  ->data[current_pc & 0xff];
+    profiling_data_t * data;
+
+    if (sampling && !sample_started) {
+        /* the alarm went off during this instruction, sample the next one */
+        return;
+    }
+
+    data = &profiling_get_page(current_context, current_pc >> 8)
+                ->data[current_pc & 0xff];
+
+    if (sampling) {
+        data->num_cycles += sample_interval;
+        data->num_samples++;
+        sample_started = false;
+        maincpu_profiling = false;
+        return;
+    }
+
     data->num_cycles += cycle_time;
     data->num_samples++;
     current_context->total_stolen_cycles_self   += stolen_cycles;
@@ -295,18 +338,59 @@ void profile_rtx(uint8_t sp)
     exited_context = true;
 }
 
-void profile_start(void)
+static void profile_reset_contexts(void)
 {
     if (root_context) free_profiling_context(root_context);
     root_context    = alloc_profiling_context();
     num_context_ids = 0;
     current_context = root_context;
-    maincpu_profiling = true;
     entered_context = false;
     exited_context  = false;
     context_dirty   = true;
 }
 
+static void profile_stop_sampling(void)
+{
+    if (sampling) {
+        alarm_unset(sample_alarm);
+        sampling = false;
+        sample_started = false;
+    }
+}
+
+void profile_start(void)
+{
+    profile_stop_sampling();
+    profile_reset_contexts();
+    maincpu_profiling = true;
+}
+
+void profile_start_sampling(unsigned int interval)
+{
+    profile_stop_sampling();
+    profile_reset_contexts();
+    maincpu_profiling = false;
+
+    if (sample_alarm == NULL) {
+        sample_alarm = alarm_new(maincpu_alarm_context, "Profiler",
+                                 profile_sample_alarm_handler, NULL);
+    }
+
+    sample_interval = interval;
+    sampling = true;
+    alarm_set(sample_alarm, maincpu_clk + interval);
+}
+
+bool profile_is_running(void)
+{
+    return maincpu_profiling || sampling;
+}
+
+bool profile_is_sampling(void)
+{
+    return sampling;
+}
+
 void compute_aggregate_stats(profiling_context_t *context) {
     profiling_context_t *c;
     profiling_counter_t total_child_cycles        = 0;
@@ -357,6 +441,7 @@ void compute_aggregate_stats(profiling_context_t *context) {
 
 void profile_stop(void)
 {
+    profile_stop_sampling();
     maincpu_profiling = false;
 }
 
@@ -374,4 +459,8 @@ static void profile_reset(void) {
 void profile_shutdown(void)
 {
     profile_reset();
+
+    /* the alarm went away with the alarm context */
+    sampling = false;
+    sample_alarm = NULL;
 }
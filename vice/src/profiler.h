@@ -34,6 +34,16 @@ extern bool maincpu_profiling;
 /* resets sample statistics and starts profiling sample collection */
 void profile_start(void);
 
+/* resets sample statistics and starts sampling the PC and call stack every
+ * `interval' cycles instead of profiling each instruction */
+void profile_start_sampling(unsigned int interval);
+
+/* true while profiling in either mode */
+bool profile_is_running(void);
+
+/* true while profiling in sampling mode */
+bool profile_is_sampling(void);
+
 /* stops profiling and writes profiling log to disk */
 void profile_stop(void);
 
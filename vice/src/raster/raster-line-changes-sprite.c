@@ -296,6 +296,7 @@ static int update_for_minor_changes_sprite(raster_t *raster,
     }
 
     if (!sprites_need_update) {
+        raster->cache_stats.sprite_cache_hits++;
         raster->sprite_status->sprite_sprite_collisions
             = cache->sprite_sprite_collisions;
         raster->sprite_status->sprite_background_collisions
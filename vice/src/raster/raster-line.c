@@ -124,6 +124,9 @@ inline static void handle_blank_line_cached(raster_t *raster)
         add_line_to_area(raster->update_area,
                          map_current_line_to_area(raster),
                          0, raster->geometry->screen_size.width - 1);
+        raster->cache_stats.lines_redrawn++;
+    } else {
+        raster->cache_stats.lines_cached++;
     }
 }
 
@@ -166,6 +169,7 @@ static void handle_blank_line(raster_t *raster)
 
             add_line_to_area(raster->update_area, map_current_line_to_area(raster),
                              0, raster->geometry->screen_size.width - 1);
+            raster->cache_stats.lines_changes++;
         } else {
             handle_blank_line_cached(raster);
         }
@@ -377,8 +381,10 @@ static void handle_visible_line_with_cache(raster_t *raster)
             raster_line_draw_borders(raster);
 
             needs_update = 1;
+            raster->cache_stats.lines_redrawn++;
         } else {
             needs_update = 0;
+            raster->cache_stats.lines_cached++;
         }
     }
 
@@ -414,6 +420,8 @@ static void handle_visible_line_without_cache(raster_t *raster)
     draw_sprites(raster);
     raster_line_draw_borders(raster);
 
+    raster->cache_stats.lines_redrawn++;
+
     cache = &raster->cache[raster->current_line];
 
     if (raster->dont_cache || raster->dont_cache_all
@@ -624,6 +632,7 @@ static void handle_visible_line_with_changes(raster_t *raster)
 
     /* Do not cache this line at all.  */
     raster->cache[raster->current_line].is_dirty = 1;
+    raster->cache_stats.lines_changes++;
 
     add_line_to_area(raster->update_area, map_current_line_to_area(raster),
                      0, raster->geometry->screen_size.width - 1);
@@ -648,6 +657,21 @@ inline static void handle_visible_line(raster_t *raster)
     }
 }
 
+/* Make the counters of the frame just finished available and start
+   counting the next one.  */
+static void cache_stats_end_of_frame(raster_t *raster)
+{
+    raster->cache_stats_frame = raster->cache_stats;
+
+    raster->cache_stats_total.lines_cached += raster->cache_stats.lines_cached;
+    raster->cache_stats_total.lines_redrawn += raster->cache_stats.lines_redrawn;
+    raster->cache_stats_total.lines_changes += raster->cache_stats.lines_changes;
+    raster->cache_stats_total.sprite_cache_hits += raster->cache_stats.sprite_cache_hits;
+    raster->cache_stats_frames++;
+
+    memset(&raster->cache_stats, 0, sizeof(raster_cache_stats_t));
+}
+
 void raster_line_emulate(raster_t *raster)
 {
     raster_draw_buffer_ptr_update(raster);
@@ -714,6 +738,7 @@ void raster_line_emulate(raster_t *raster)
         /* not end of frame on NTSC VIC-II where lines 0+ are */
         /* displayed in the lower border */
         if (raster->geometry->screen_size.height > raster->geometry->last_displayed_line) {
+            cache_stats_end_of_frame(raster);
             raster_canvas_handle_end_of_frame(raster);
         }
     }
@@ -721,6 +746,7 @@ void raster_line_emulate(raster_t *raster)
     /* end of frame on NTSC VIC-II */
     if (raster->geometry->screen_size.height <= raster->geometry->last_displayed_line
         && raster->current_line == raster->geometry->last_displayed_line - raster->geometry->screen_size.height + 1) {
+        cache_stats_end_of_frame(raster);
         raster_canvas_handle_end_of_frame(raster);
     }
 
@@ -268,6 +268,11 @@ int raster_init(raster_t *raster,
     raster->dont_cache_all = 1;
     raster->num_cached_lines = 0;
 
+    memset(&raster->cache_stats, 0, sizeof(raster_cache_stats_t));
+    memset(&raster->cache_stats_frame, 0, sizeof(raster_cache_stats_t));
+    memset(&raster->cache_stats_total, 0, sizeof(raster_cache_stats_t));
+    raster->cache_stats_frames = 0;
+
     raster->fake_draw_buffer_line = NULL;
 
     raster->can_disable_border = 0;
@@ -358,6 +363,43 @@ void raster_mode_change(void)
 }
 
 
+/* Return the cache statistics of the `index'th active raster, or -1 if
+   there is no such raster.  */
+int raster_cache_stats_get(unsigned int index, const char **name,
+                           const raster_cache_stats_t **frame,
+                           const raster_cache_stats_t **total,
+                           unsigned int *frames)
+{
+    raster_list_t *rasters = ActiveRasters;
+
+    while (rasters != NULL && index > 0) {
+        rasters = rasters->next;
+        index--;
+    }
+
+    if (rasters == NULL) {
+        return -1;
+    }
+
+    *name = rasters->raster->canvas->videoconfig->chip_name;
+    *frame = &rasters->raster->cache_stats_frame;
+    *total = &rasters->raster->cache_stats_total;
+    *frames = rasters->raster->cache_stats_frames;
+
+    return 0;
+}
+
+void raster_cache_stats_reset(void)
+{
+    raster_list_t *rasters = ActiveRasters;
+
+    while (rasters != NULL) {
+        memset(&rasters->raster->cache_stats_total, 0, sizeof(raster_cache_stats_t));
+        rasters->raster->cache_stats_frames = 0;
+        rasters = rasters->next;
+    }
+}
+
 void raster_new_cache(raster_t *raster, unsigned int screen_height)
 {
     unsigned int i;
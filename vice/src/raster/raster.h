@@ -61,6 +61,22 @@ struct raster_modes_s;
 struct raster_resource_chip_s;
 struct raster_sprite_status_s;
 
+/* Per-frame counters of how the lines of a frame were produced.  */
+struct raster_cache_stats_s {
+    /* Lines taken from the cache without redrawing.  */
+    unsigned int lines_cached;
+
+    /* Lines that had to be redrawn completely.  */
+    unsigned int lines_redrawn;
+
+    /* Lines that had mid-line changes.  */
+    unsigned int lines_changes;
+
+    /* Sprite lines that matched the sprite cache.  */
+    unsigned int sprite_cache_hits;
+};
+typedef struct raster_cache_stats_s raster_cache_stats_t;
+
 struct raster_s {
     struct viewport_s *viewport;
     struct geometry_s *geometry;
@@ -158,6 +174,13 @@ struct raster_s {
        is valid again.  */
     unsigned int num_cached_lines;
 
+    /* Cache statistics for the frame being drawn, the last complete frame
+       and the sum since the last reset.  */
+    raster_cache_stats_t cache_stats;
+    raster_cache_stats_t cache_stats_frame;
+    raster_cache_stats_t cache_stats_total;
+    unsigned int cache_stats_frames;
+
     /* Area to update.  */
     struct raster_canvas_area_s *update_area;
 
@@ -217,6 +240,11 @@ void raster_screenshot(raster_t *raster, struct screenshot_s *screenshot);
 void raster_async_refresh(raster_t *raster, struct canvas_refresh_s *ref);
 void raster_line_changes_init(raster_t *raster);
 void raster_line_changes_sprite_init(raster_t *raster);
+int raster_cache_stats_get(unsigned int index, const char **name,
+                           const raster_cache_stats_t **frame,
+                           const raster_cache_stats_t **total,
+                           unsigned int *frames);
+void raster_cache_stats_reset(void);
 void raster_calculate_padding_size(unsigned int fb_width, unsigned int fb_height, unsigned int *padded_size, unsigned int *unpadded_offset);
 
 #endif
@@ -0,0 +1,595 @@
+/*
+ * rewind.c - Periodic in-memory snapshots for rewinding the emulation.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The rewind buffer is a ring of machine snapshots taken every
+   `RewindInterval' frames into memory.  To keep the memory footprint low
+   only every REWIND_KEYFRAME_INTERVAL'th entry holds a complete snapshot,
+   the entries in between only hold the byte ranges that changed since the
+   previous entry.  The oldest entry in the ring is always a complete one.
+
+   Delta format: a sequence of records, each consisting of the number of
+   unchanged bytes to skip and the number of changed bytes that follow
+   (both as 7-bit variable length integers), followed by the changed bytes
+   themselves.  */
+
+/* #define DEBUG_REWIND */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "cmdline.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "network.h"
+#include "resources.h"
+#include "snapshot.h"
+#include "types.h"
+#include "vice-event.h"
+
+#include "rewind.h"
+
+#ifdef DEBUG_REWIND
+#define DBG(x)  log_debug x
+#else
+#define DBG(x)
+#endif
+
+/* Store a complete snapshot at least every this many entries.  */
+#define REWIND_KEYFRAME_INTERVAL    32
+
+/* Unchanged gaps shorter than this are stored as part of a changed run,
+   since a new record would cost more than it saves.  */
+#define REWIND_DELTA_GAP            8
+
+typedef struct rewind_entry_s {
+    /* Complete snapshot or delta to the previous entry.  */
+    uint8_t *data;
+
+    /* Number of bytes in `data'.  */
+    size_t size;
+
+    /* Size of the complete snapshot this entry decodes to.  */
+    size_t full_size;
+
+    /* Flag: does `data' hold a complete snapshot?  */
+    int keyframe;
+} rewind_entry_t;
+
+static log_t rewind_log = LOG_DEFAULT;
+
+/* Resources.  */
+static int rewind_enabled = 0;
+static int rewind_interval = 10;
+static int rewind_depth = 300;
+static int rewind_memory_limit = 128;
+
+/* The ring of snapshots, `rewind_count' entries starting at
+   `rewind_first'.  */
+static rewind_entry_t *rewind_entries = NULL;
+static int rewind_entries_max = 0;
+static int rewind_first = 0;
+static int rewind_count = 0;
+
+/* Bytes allocated for snapshot data in the ring.  */
+static size_t rewind_memory_used = 0;
+
+/* Target of machine_write_snapshot_memory() and source of
+   machine_read_snapshot_memory().  */
+static snapshot_memory_t *rewind_mem = NULL;
+
+/* Decoded copy of the newest entry, deltas are computed against it.  */
+static uint8_t *last_image = NULL;
+static size_t last_size = 0;
+static size_t last_alloc = 0;
+
+/* Scratch buffer for encoding deltas.  */
+static uint8_t *delta_buf = NULL;
+static size_t delta_alloc = 0;
+
+static int frames_since_capture = 0;
+static int captures_since_keyframe = 0;
+static int capture_pending = 0;
+static unsigned int rewind_frames_pending = 0;
+
+/* Statistics, logged on shutdown.  */
+static unsigned long stat_captures = 0;
+static unsigned long stat_keyframes = 0;
+static uint64_t stat_capture_ticks = 0;
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t *put_varint(uint8_t *p, size_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, size_t *value)
+{
+    size_t result = 0;
+    int shift = 0;
+    uint8_t b;
+
+    do {
+        if (p >= end) {
+            return NULL;
+        }
+        b = *p++;
+        result |= (size_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    *value = result;
+    return p;
+}
+
+/* Encode the differences between `prev' and `cur' into `out'.  Returns the
+   size of the delta, or 0 if it would not fit into `limit' bytes.  */
+static size_t delta_encode(const uint8_t *prev, const uint8_t *cur, size_t size,
+                           uint8_t *out, size_t limit)
+{
+    uint8_t *p = out;
+    size_t i = 0;
+
+    while (i < size) {
+        size_t start = i;
+        size_t lit_start, last_diff, j;
+
+        while (i < size && prev[i] == cur[i]) {
+            i++;
+        }
+        if (i == size) {
+            break;
+        }
+
+        lit_start = last_diff = i;
+        for (j = i; j < size && j - last_diff <= REWIND_DELTA_GAP; j++) {
+            if (prev[j] != cur[j]) {
+                last_diff = j;
+            }
+        }
+        i = last_diff + 1;
+
+        /* two varints take at most 20 bytes */
+        if ((size_t)(p - out) + 20 + (i - lit_start) > limit) {
+            return 0;
+        }
+        p = put_varint(p, lit_start - start);
+        p = put_varint(p, i - lit_start);
+        memcpy(p, cur + lit_start, i - lit_start);
+        p += i - lit_start;
+    }
+
+    return (size_t)(p - out);
+}
+
+/* Apply the delta in `data' to the image in `dest'.  */
+static int delta_apply(uint8_t *dest, size_t size, const uint8_t *data, size_t data_size)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + data_size;
+    size_t pos = 0;
+
+    while (p < end) {
+        size_t skip, len;
+
+        p = get_varint(p, end, &skip);
+        if (p == NULL) {
+            return -1;
+        }
+        p = get_varint(p, end, &len);
+        if (p == NULL || pos + skip + len > size || len > (size_t)(end - p)) {
+            return -1;
+        }
+        pos += skip;
+        memcpy(dest + pos, p, len);
+        p += len;
+        pos += len;
+    }
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static rewind_entry_t *rewind_entry(int n)
+{
+    return &rewind_entries[(rewind_first + n) % rewind_entries_max];
+}
+
+static void rewind_drop_newest(void)
+{
+    rewind_entry_t *e = rewind_entry(rewind_count - 1);
+
+    rewind_memory_used -= e->size;
+    lib_free(e->data);
+    e->data = NULL;
+    rewind_count--;
+}
+
+/* Drop the oldest entry.  If the entry after it is a delta it is turned
+   into a complete snapshot, reusing the buffer of the dropped entry.  */
+static void rewind_drop_oldest(void)
+{
+    rewind_entry_t *e = rewind_entry(0);
+
+    if (rewind_count > 1) {
+        rewind_entry_t *next = rewind_entry(1);
+
+        if (!next->keyframe) {
+            delta_apply(e->data, e->full_size, next->data, next->size);
+            rewind_memory_used -= next->size;
+            lib_free(next->data);
+            next->data = e->data;
+            next->size = e->full_size;
+            next->keyframe = 1;
+            rewind_memory_used += next->size;
+            e->data = NULL;
+            e->size = 0;
+        }
+    }
+
+    rewind_memory_used -= e->size;
+    lib_free(e->data);
+    e->data = NULL;
+    rewind_first = (rewind_first + 1) % rewind_entries_max;
+    rewind_count--;
+}
+
+void rewind_clear(void)
+{
+    while (rewind_count > 0) {
+        rewind_drop_newest();
+    }
+    rewind_first = 0;
+    frames_since_capture = 0;
+    captures_since_keyframe = 0;
+    last_size = 0;
+}
+
+static void rewind_set_last_image(const uint8_t *data, size_t size)
+{
+    if (size > last_alloc) {
+        last_image = lib_realloc(last_image, size);
+        last_alloc = size;
+    }
+    memcpy(last_image, data, size);
+    last_size = size;
+}
+
+static void rewind_capture_trap(uint16_t addr, void *data)
+{
+    const uint8_t *image;
+    rewind_entry_t *e;
+    size_t size, delta_size = 0;
+    size_t limit = (size_t)rewind_memory_limit * 1024 * 1024;
+    tick_t start;
+
+    capture_pending = 0;
+
+    if (!rewind_enabled || rewind_entries == NULL) {
+        return;
+    }
+
+    start = tick_now();
+
+    if (machine_write_snapshot_memory(rewind_mem, 0, 0, 0) < 0) {
+        log_error(rewind_log, "Cannot take rewind snapshot, disabling rewind.");
+        snapshot_set_error(SNAPSHOT_NO_ERROR);
+        resources_set_int("RewindEnable", 0);
+        return;
+    }
+    image = snapshot_memory_get_data(rewind_mem, &size);
+
+    if (rewind_count == rewind_entries_max) {
+        rewind_drop_oldest();
+    }
+
+    if (rewind_count > 0 && last_size == size
+        && captures_since_keyframe < REWIND_KEYFRAME_INTERVAL - 1) {
+        if (delta_alloc < size / 2) {
+            delta_alloc = size / 2;
+            delta_buf = lib_realloc(delta_buf, delta_alloc);
+        }
+        delta_size = delta_encode(last_image, image, size, delta_buf, size / 2);
+    }
+
+    e = rewind_entry(rewind_count);
+    e->full_size = size;
+    if (delta_size > 0) {
+        e->data = lib_malloc(delta_size);
+        memcpy(e->data, delta_buf, delta_size);
+        e->size = delta_size;
+        e->keyframe = 0;
+        captures_since_keyframe++;
+    } else {
+        e->data = lib_malloc(size);
+        memcpy(e->data, image, size);
+        e->size = size;
+        e->keyframe = 1;
+        captures_since_keyframe = 0;
+        stat_keyframes++;
+    }
+    rewind_memory_used += e->size;
+    rewind_count++;
+
+    rewind_set_last_image(image, size);
+
+    while (rewind_count > 1 && rewind_memory_used > limit) {
+        rewind_drop_oldest();
+    }
+
+    stat_captures++;
+    stat_capture_ticks += tick_now_delta(start);
+
+    DBG(("rewind: captured %" PRI_SIZE_T " bytes as %s (%d entries, %" PRI_SIZE_T " bytes used)",
+         e->size, e->keyframe ? "keyframe" : "delta", rewind_count, rewind_memory_used));
+}
+
+static void rewind_restore_trap(uint16_t addr, void *data)
+{
+    rewind_entry_t *e;
+    uint8_t *image;
+    size_t size;
+    int target, key, i;
+    unsigned int frames = rewind_frames_pending;
+
+    rewind_frames_pending = 0;
+
+    if (rewind_count == 0) {
+        return;
+    }
+
+    /* The newest entry is up to `rewind_interval' frames old already.  */
+    target = rewind_count - 1 - (int)(frames / (unsigned int)rewind_interval);
+    if (target < 0) {
+        target = 0;
+    }
+
+    for (key = target; !rewind_entry(key)->keyframe; key--) {
+    }
+
+    e = rewind_entry(key);
+    size = e->full_size;
+    image = lib_malloc(size);
+    memcpy(image, e->data, size);
+    for (i = key + 1; i <= target; i++) {
+        e = rewind_entry(i);
+        if (delta_apply(image, size, e->data, e->size) < 0) {
+            log_error(rewind_log, "Corrupt rewind buffer, clearing it.");
+            lib_free(image);
+            rewind_clear();
+            return;
+        }
+    }
+
+    snapshot_memory_set_data(rewind_mem, image, size);
+    if (machine_read_snapshot_memory(rewind_mem, 0) < 0) {
+        log_error(rewind_log, "Cannot restore rewind snapshot.");
+        snapshot_set_error(SNAPSHOT_NO_ERROR);
+        lib_free(image);
+        rewind_clear();
+        return;
+    }
+
+    /* Continue the timeline from the restored entry.  */
+    while (rewind_count > target + 1) {
+        rewind_drop_newest();
+    }
+    rewind_set_last_image(image, size);
+    lib_free(image);
+    captures_since_keyframe = target - key;
+    frames_since_capture = 0;
+
+    log_message(rewind_log, "Rewound %u frames.", frames);
+}
+
+/* Go back at least `frames' frames to the nearest snapshot in the buffer.
+   The actual restore happens at the next instruction boundary.  */
+int rewind_step_back_frames(unsigned int frames)
+{
+    if (!rewind_enabled || rewind_count == 0) {
+        return -1;
+    }
+    if (rewind_frames_pending == 0) {
+        interrupt_maincpu_trigger_trap(rewind_restore_trap, NULL);
+    }
+    rewind_frames_pending += frames;
+    return 0;
+}
+
+int rewind_step_back_seconds(unsigned int seconds)
+{
+    long cycles_per_frame = machine_get_cycles_per_frame();
+    unsigned int fps = 50;
+
+    if (cycles_per_frame > 0) {
+        fps = (unsigned int)(machine_get_cycles_per_second() / cycles_per_frame);
+    }
+    return rewind_step_back_frames(seconds * fps);
+}
+
+/* Called once per frame.  */
+void rewind_vsync_hook(void)
+{
+    if (!rewind_enabled || capture_pending) {
+        return;
+    }
+
+    if (++frames_since_capture < rewind_interval) {
+        return;
+    }
+    frames_since_capture = 0;
+
+    /* Restoring snapshots would break event recording and netplay.  */
+    if (event_record_active() || event_playback_active() || network_connected()) {
+        return;
+    }
+
+    capture_pending = 1;
+    interrupt_maincpu_trigger_trap(rewind_capture_trap, NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void rewind_alloc_entries(void)
+{
+    rewind_clear();
+    lib_free(rewind_entries);
+    rewind_entries = lib_calloc((size_t)rewind_depth, sizeof(rewind_entry_t));
+    rewind_entries_max = rewind_depth;
+}
+
+static void rewind_free(void)
+{
+    rewind_clear();
+    lib_free(rewind_entries);
+    rewind_entries = NULL;
+    rewind_entries_max = 0;
+    lib_free(last_image);
+    last_image = NULL;
+    last_alloc = 0;
+    lib_free(delta_buf);
+    delta_buf = NULL;
+    delta_alloc = 0;
+    snapshot_memory_destroy(rewind_mem);
+    rewind_mem = NULL;
+}
+
+static int set_rewind_enabled(int val, void *param)
+{
+    val = val ? 1 : 0;
+
+    if (val == rewind_enabled) {
+        return 0;
+    }
+
+    if (val) {
+        if (rewind_log == LOG_DEFAULT) {
+            rewind_log = log_open("Rewind");
+        }
+        rewind_mem = snapshot_memory_new();
+        rewind_alloc_entries();
+    } else {
+        rewind_free();
+    }
+    rewind_enabled = val;
+
+    return 0;
+}
+
+static int set_rewind_interval(int val, void *param)
+{
+    if (val < 1 || val > 1000) {
+        return -1;
+    }
+    rewind_interval = val;
+
+    return 0;
+}
+
+static int set_rewind_depth(int val, void *param)
+{
+    if (val < 1 || val > 100000) {
+        return -1;
+    }
+    rewind_depth = val;
+    if (rewind_enabled) {
+        rewind_alloc_entries();
+    }
+
+    return 0;
+}
+
+static int set_rewind_memory_limit(int val, void *param)
+{
+    if (val < 1 || val > 4096) {
+        return -1;
+    }
+    rewind_memory_limit = val;
+
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "RewindEnable", 0, RES_EVENT_NO, NULL,
+      &rewind_enabled, set_rewind_enabled, NULL },
+    { "RewindInterval", 10, RES_EVENT_NO, NULL,
+      &rewind_interval, set_rewind_interval, NULL },
+    { "RewindDepth", 300, RES_EVENT_NO, NULL,
+      &rewind_depth, set_rewind_depth, NULL },
+    { "RewindMemoryLimit", 128, RES_EVENT_NO, NULL,
+      &rewind_memory_limit, set_rewind_memory_limit, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int rewind_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-rewind", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "RewindEnable", (resource_value_t)1,
+      NULL, "Enable the rewind buffer" },
+    { "+rewind", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "RewindEnable", (resource_value_t)0,
+      NULL, "Disable the rewind buffer" },
+    { "-rewindinterval", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindInterval", NULL,
+      "<frames>", "Take a rewind snapshot every <frames> frames (1-1000)" },
+    { "-rewinddepth", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindDepth", NULL,
+      "<number>", "Keep at most <number> rewind snapshots" },
+    { "-rewindmemory", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RewindMemoryLimit", NULL,
+      "<MiB>", "Limit the memory used by the rewind buffer to <MiB> MiB" },
+    CMDLINE_LIST_END
+};
+
+int rewind_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+void rewind_shutdown(void)
+{
+    if (stat_captures > 0) {
+        log_message(rewind_log, "%lu snapshots (%lu complete), %lu us per snapshot, %" PRI_SIZE_T " KiB in use.",
+                    stat_captures, stat_keyframes,
+                    (unsigned long)TICK_TO_MICRO(stat_capture_ticks / stat_captures),
+                    rewind_memory_used / 1024);
+    }
+    rewind_free();
+}
@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "crc32.h"
 #include "gfxoutput.h"
 #include "lib.h"
 #include "log.h"
@@ -223,6 +224,47 @@ int screenshot_save(const char *drvname, const char *filename,
     return result;
 }
 
+/** \brief  Compute the CRC32 of the screen of \a canvas
+ *
+ * The checksum covers the area screenshot_save() would save, as palette
+ * indices, so it does not depend on the palette in use.
+ *
+ * \param[in]   canvas  video canvas
+ * \param[out]  crc     CRC32 of the screen
+ *
+ * \return  0 on success, -1 on failure
+ */
+int screenshot_crc32(struct video_canvas_s *canvas, uint32_t *crc)
+{
+    screenshot_t screenshot;
+    uint8_t *data;
+    unsigned int i;
+
+    if (canvas == NULL || machine_screenshot(&screenshot, canvas) < 0) {
+        return -1;
+    }
+
+    screenshot.width = screenshot.max_width & ~3;
+    screenshot.height = screenshot.last_displayed_line - screenshot.first_displayed_line + 1;
+    screenshot.y_offset = screenshot.first_displayed_line;
+
+    screenshot.color_map = lib_calloc(1, 256);
+    for (i = 0; i < screenshot.palette->num_entries; i++) {
+        screenshot.color_map[i] = i;
+    }
+
+    data = lib_malloc(screenshot.width * screenshot.height);
+    for (i = 0; i < screenshot.height; i++) {
+        screenshot_line_data(&screenshot, data + i * screenshot.width, i,
+                             SCREENSHOT_MODE_PALETTE);
+    }
+    *crc = crc32_buf((const char *)data, screenshot.width * screenshot.height);
+
+    lib_free(data);
+    lib_free(screenshot.color_map);
+    return 0;
+}
+
 #ifdef FEATURE_CPUMEMHISTORY
 int memmap_screenshot_save(const char *drvname, const char *filename, int x_size, int y_size, uint8_t *gfx, uint8_t *palette)
 {
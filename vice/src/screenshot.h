@@ -127,6 +127,7 @@ typedef struct screenshot_s {
 int screenshot_init(void);
 void screenshot_shutdown(void);
 int screenshot_save(const char *drvname, const char *filename, struct video_canvas_s *canvas);
+int screenshot_crc32(struct video_canvas_s *canvas, uint32_t *crc);
 int screenshot_record(void);
 void screenshot_stop_recording(void);
 int screenshot_is_recording(void);
@@ -62,6 +62,7 @@ static int sid_resid_8580_passband;
 static int sid_resid_8580_gain;
 static int sid_resid_8580_filter_bias;
 static int sid_resid_enable_raw_output;
+static int sid_resid_threads;
 #endif
 int sid_stereo = 0;
 int checking_sid_stereo;
@@ -148,10 +149,25 @@ static int set_sid_resid_enable_raw_output(int val, void *param)
 {
     sid_resid_enable_raw_output = val ? 1 : 0;
 
+    /* the raw output file is shared by all chips */
+    sid_set_render_threads(sid_resid_enable_raw_output ? 0 : sid_resid_threads);
+
     sid_state_changed = 1;
 
     return 0;
 }
+
+static int set_sid_resid_threads(int val, void *param)
+{
+    if (val < 0 || val > (SOUND_SIDS_MAX - 1)) {
+        return -1;
+    }
+    sid_resid_threads = val;
+
+    sid_set_render_threads(sid_resid_enable_raw_output ? 0 : sid_resid_threads);
+
+    return 0;
+}
 #endif
 
 static int set_sid_stereo(int val, void *param)
@@ -396,6 +412,8 @@ static const resource_int_t resid_resources_int[] = {
       &sid_resid_8580_gain, set_sid_resid_8580_gain, NULL },
     { "SidResid8580FilterBias", 0, RES_EVENT_NO, NULL,
       &sid_resid_8580_filter_bias, set_sid_resid_8580_filter_bias, NULL },
+    { "SidResidThreads", 0, RES_EVENT_NO, NULL,
+      &sid_resid_threads, set_sid_resid_threads, NULL },
     RESOURCE_INT_LIST_END
 };
 #endif
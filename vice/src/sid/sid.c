@@ -34,6 +34,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
 #include "alarm.h"
 #include "catweaselmkiii.h"
 #include "fastsid.h"
@@ -566,6 +570,189 @@ GETBUFx(7)
 
 #endif
 
+#ifndef SOUND_SYSTEM_FLOAT
+/* Rendering several SIDs in parallel.
+
+   Every call of sid_sound_machine_calculate_samples() clocks all SIDs over
+   the same stretch of cycles, and the chips share no state.  So with
+   SidResidThreads > 0 the reSID instances are clocked on worker threads,
+   and the results are mixed on the emulation thread in the same order as
+   before, which keeps the output identical.  Register writes need no
+   queueing, since sound_store() brings all chips up to date before a write
+   is applied.  */
+
+/* Short stretches are rendered on the emulation thread, handing them to
+   the workers would cost more than it gains.  */
+#define SID_RENDER_MIN_SAMPLES  64
+
+typedef struct sid_render_job_s {
+    sound_t *psid;
+    int16_t *pbuf;
+    int interleave;
+    CLOCK delta_t;
+    int nr;
+} sid_render_job_t;
+
+static sid_render_job_t sid_render_jobs[SOUND_SIDS_MAX];
+static int sid_render_job_count = 0;
+
+/* Number of worker threads requested by the resources.  */
+static int sid_render_threads = 0;
+
+static void sid_render_add(sound_t *psid, int16_t *pbuf, int interleave)
+{
+    sid_render_job_t *job = &sid_render_jobs[sid_render_job_count++];
+
+    job->psid = psid;
+    job->pbuf = pbuf;
+    job->interleave = interleave;
+}
+
+static void sid_render_job_run(sid_render_job_t *job, int nr)
+{
+    job->nr = sid_engine.calculate_samples(job->psid, job->pbuf, nr, job->interleave, &job->delta_t);
+}
+
+#ifdef USE_VICE_THREAD
+static pthread_t sid_render_workers[SOUND_SIDS_MAX - 1];
+static int sid_render_workers_running = 0;
+
+static pthread_mutex_t sid_render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sid_render_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sid_render_done = PTHREAD_COND_INITIALIZER;
+
+/* All of these are protected by sid_render_lock.  */
+static unsigned int sid_render_generation = 0;
+static int sid_render_next = 0;
+static int sid_render_pending = 0;
+static int sid_render_nr = 0;
+static int sid_render_quit = 0;
+
+/* Take jobs until none are left.  Called with sid_render_lock held.  */
+static void sid_render_take_jobs(void)
+{
+    while (sid_render_next < sid_render_job_count) {
+        sid_render_job_t *job = &sid_render_jobs[sid_render_next++];
+        int nr = sid_render_nr;
+
+        pthread_mutex_unlock(&sid_render_lock);
+        sid_render_job_run(job, nr);
+        pthread_mutex_lock(&sid_render_lock);
+
+        if (--sid_render_pending == 0) {
+            pthread_cond_signal(&sid_render_done);
+        }
+    }
+}
+
+static void *sid_render_thread(void *unused)
+{
+    unsigned int generation = 0;
+
+    pthread_mutex_lock(&sid_render_lock);
+    for (;;) {
+        while (!sid_render_quit && generation == sid_render_generation) {
+            pthread_cond_wait(&sid_render_start, &sid_render_lock);
+        }
+        if (sid_render_quit) {
+            break;
+        }
+        generation = sid_render_generation;
+        sid_render_take_jobs();
+    }
+    pthread_mutex_unlock(&sid_render_lock);
+
+    return NULL;
+}
+
+static void sid_render_stop_workers(void)
+{
+    int i;
+
+    if (sid_render_workers_running == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&sid_render_lock);
+    sid_render_quit = 1;
+    pthread_cond_broadcast(&sid_render_start);
+    pthread_mutex_unlock(&sid_render_lock);
+
+    for (i = 0; i < sid_render_workers_running; i++) {
+        pthread_join(sid_render_workers[i], NULL);
+    }
+    sid_render_workers_running = 0;
+    sid_render_quit = 0;
+}
+
+static void sid_render_start_workers(int threads)
+{
+    while (sid_render_workers_running < threads) {
+        if (pthread_create(&sid_render_workers[sid_render_workers_running], NULL,
+                           sid_render_thread, NULL) != 0) {
+            break;
+        }
+        sid_render_workers_running++;
+    }
+}
+#endif
+
+/* Run the queued jobs, all starting with `delta_t' cycles to go.  The
+   last job's results are returned, just like the serial code did.  */
+static int sid_render_run(int nr, CLOCK *delta_t)
+{
+    sid_render_job_t *last;
+    int i;
+
+    for (i = 0; i < sid_render_job_count; i++) {
+        sid_render_jobs[i].delta_t = *delta_t;
+    }
+
+#ifdef USE_VICE_THREAD
+    if (sid_render_workers_running != sid_render_threads) {
+        sid_render_stop_workers();
+        sid_render_start_workers(sid_render_threads);
+    }
+
+    if (sid_render_workers_running > 0 && sidengine == SID_ENGINE_RESID
+        && nr >= SID_RENDER_MIN_SAMPLES) {
+        pthread_mutex_lock(&sid_render_lock);
+        sid_render_nr = nr;
+        sid_render_next = 0;
+        sid_render_pending = sid_render_job_count;
+        sid_render_generation++;
+        pthread_cond_broadcast(&sid_render_start);
+
+        /* lend a hand, then wait for the stragglers */
+        sid_render_take_jobs();
+        while (sid_render_pending > 0) {
+            pthread_cond_wait(&sid_render_done, &sid_render_lock);
+        }
+        pthread_mutex_unlock(&sid_render_lock);
+    } else
+#endif
+    {
+        for (i = 0; i < sid_render_job_count; i++) {
+            sid_render_job_run(&sid_render_jobs[i], nr);
+        }
+    }
+
+    last = &sid_render_jobs[sid_render_job_count - 1];
+    *delta_t = last->delta_t;
+    sid_render_job_count = 0;
+
+    return last->nr;
+}
+#endif
+
+/* Set the number of threads used for rendering multiple SIDs.  */
+void sid_set_render_threads(int threads)
+{
+#ifndef SOUND_SYSTEM_FLOAT
+    sid_render_threads = threads;
+#endif
+}
+
 int sid_sound_machine_init_vbr(sound_t *psid, int speed, int cycles_per_sec, int factor)
 {
     return sid_engine.init(psid, speed * factor / 1000, cycles_per_sec, factor);
@@ -578,6 +765,9 @@ int sid_sound_machine_init(sound_t *psid, int speed, int cycles_per_sec)
 
 void sid_sound_machine_close(sound_t *psid)
 {
+#if !defined(SOUND_SYSTEM_FLOAT) && defined(USE_VICE_THREAD)
+    sid_render_stop_workers();
+#endif
     sid_engine.close(psid);
 #ifndef SOUND_SYSTEM_FLOAT
     /* free the temp. buffers */
@@ -652,15 +842,15 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     int16_t *tmp_buf6;
     int16_t *tmp_buf7;
     int tmp_nr = 0;
-    CLOCK tmp_delta_t = *delta_t;
 
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_1_DEVICE) {
         return sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
     }
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_2_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
         }
@@ -669,10 +859,10 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     if (soc == SOUND_OUTPUT_MONO && scc == SOUND_3_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[2], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -683,12 +873,11 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[2], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[3], tmp_buf3, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -701,14 +890,12 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[2], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[3], tmp_buf3, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[4], tmp_buf4, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -723,16 +910,13 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
         tmp_buf5 = getbuf5(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[2], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[3], tmp_buf3, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[4], tmp_buf4, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[5], tmp_buf5, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -749,18 +933,14 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf4 = getbuf4(2 * nr);
         tmp_buf5 = getbuf5(2 * nr);
         tmp_buf6 = getbuf6(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[2], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[3], tmp_buf3, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[4], tmp_buf4, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[5], tmp_buf5, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[6], tmp_buf6, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -779,20 +959,15 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf5 = getbuf5(2 * nr);
         tmp_buf6 = getbuf6(2 * nr);
         tmp_buf7 = getbuf7(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf7, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, SOUND_OUTPUT_MONO, delta_t);
+        sid_render_add(psid[0], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[2], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[3], tmp_buf3, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[4], tmp_buf4, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[5], tmp_buf5, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[6], tmp_buf6, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[7], tmp_buf7, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[1], pbuf, SOUND_OUTPUT_MONO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -812,16 +987,17 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_2_DEVICES) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         return tmp_nr;
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_3_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[2], tmp_buf1, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[i]);
@@ -829,12 +1005,11 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     }
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_4_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[2], tmp_buf1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[3], tmp_buf1 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
@@ -843,14 +1018,12 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_5_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[2], tmp_buf1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[3], tmp_buf1 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[4], tmp_buf2, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i]);
@@ -861,16 +1034,13 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     if (soc == SOUND_OUTPUT_STEREO && scc == SOUND_6_DEVICES) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[2], tmp_buf1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[3], tmp_buf1 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[4], tmp_buf2, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[5], tmp_buf2 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
@@ -882,18 +1052,14 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, SOUND_OUTPUT_MONO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[2], tmp_buf1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[3], tmp_buf1 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[4], tmp_buf2, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[5], tmp_buf2 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[6], tmp_buf3, SOUND_OUTPUT_MONO);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
@@ -907,20 +1073,15 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf3 + 1, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, SOUND_OUTPUT_STEREO, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, SOUND_OUTPUT_STEREO, delta_t);
+        sid_render_add(psid[2], tmp_buf1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[3], tmp_buf1 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[4], tmp_buf2, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[5], tmp_buf2 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[6], tmp_buf3, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[7], tmp_buf3 + 1, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[0], pbuf, SOUND_OUTPUT_STEREO);
+        sid_render_add(psid[1], pbuf + 1, SOUND_OUTPUT_STEREO);
+        tmp_nr = sid_render_run(nr, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf2[i * 2]);
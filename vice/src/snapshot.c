@@ -67,10 +67,36 @@ static const char snapshot_version_magic_string[] = "VICE Version\032";
 #define SNAPSHOT_MAGIC_LEN              19
 #define SNAPSHOT_VERSION_MAGIC_LEN      13
 
-struct snapshot_module_s {
-    /* File descriptor.  */
+/* In-memory snapshot image.  The buffer only ever grows, so taking many
+   snapshots into the same object does not allocate after the first one.  */
+struct snapshot_memory_s {
+    /* Snapshot data.  */
+    uint8_t *data;
+
+    /* Number of valid bytes in `data'.  */
+    size_t size;
+
+    /* Allocated size of `data'.  */
+    size_t alloc;
+};
+
+/* Stream a snapshot is read from or written to: either a stdio file or a
+   memory buffer.  */
+typedef struct snapshot_stream_s {
+    /* File descriptor, NULL if the snapshot lives in memory.  */
     FILE *file;
 
+    /* Memory buffer, NULL if the snapshot lives in a file.  */
+    snapshot_memory_t *mem;
+
+    /* Current position in the memory buffer.  */
+    size_t pos;
+} snapshot_stream_t;
+
+struct snapshot_module_s {
+    /* Stream of the snapshot this module belongs to.  */
+    snapshot_stream_t *file;
+
     /* Flag: are we writing it?  */
     int write_mode;
 
@@ -85,8 +111,8 @@ struct snapshot_module_s {
 };
 
 struct snapshot_s {
-    /* File descriptor.  */
-    FILE *file;
+    /* Stream the snapshot is read from or written to.  */
+    snapshot_stream_t stream;
 
     /* Offset of the first module.  */
     long first_module_offset;
@@ -95,12 +121,109 @@ struct snapshot_s {
     int write_mode;
 };
 
+/* Memory buffer used by the next snapshot_create()/snapshot_open() call
+   instead of a file, if not NULL.  */
+static snapshot_memory_t *selected_memory = NULL;
+
 /* ------------------------------------------------------------------------- */
 
-static int snapshot_write_byte(FILE *f, uint8_t data)
+/* Low level stream access.  These map to stdio for file based snapshots and
+   to plain memory copies for snapshots held in a snapshot_memory_t.  */
+
+static long stream_tell(snapshot_stream_t *f)
+{
+    if (f->mem != NULL) {
+        return (long)f->pos;
+    }
+    return ftell(f->file);
+}
+
+static int stream_seek(snapshot_stream_t *f, long offset)
+{
+    if (f->mem != NULL) {
+        if (offset < 0) {
+            return -1;
+        }
+        f->pos = (size_t)offset;
+        return 0;
+    }
+    return fseek(f->file, offset, SEEK_SET);
+}
+
+static int stream_write(snapshot_stream_t *f, const void *data, size_t num)
 {
-    current_fpos = ftell(f);
-    if (fputc(data, f) == EOF) {
+    snapshot_memory_t *mem = f->mem;
+
+    if (mem == NULL) {
+        return (fwrite(data, num, 1, f->file) < 1) ? -1 : 0;
+    }
+
+    if (f->pos + num > mem->alloc) {
+        size_t new_alloc = mem->alloc ? mem->alloc * 2 : 0x10000;
+
+        while (new_alloc < f->pos + num) {
+            new_alloc *= 2;
+        }
+        mem->data = lib_realloc(mem->data, new_alloc);
+        mem->alloc = new_alloc;
+    }
+    if (f->pos > mem->size) {
+        memset(mem->data + mem->size, 0, f->pos - mem->size);
+    }
+    memcpy(mem->data + f->pos, data, num);
+    f->pos += num;
+    if (f->pos > mem->size) {
+        mem->size = f->pos;
+    }
+    return 0;
+}
+
+static int stream_read(snapshot_stream_t *f, void *data, size_t num)
+{
+    snapshot_memory_t *mem = f->mem;
+
+    if (mem == NULL) {
+        return (fread(data, num, 1, f->file) < 1) ? -1 : 0;
+    }
+
+    if (f->pos + num > mem->size) {
+        f->pos = mem->size;
+        return -1;
+    }
+    memcpy(data, mem->data + f->pos, num);
+    f->pos += num;
+    return 0;
+}
+
+static int stream_putc(snapshot_stream_t *f, uint8_t data)
+{
+    if (f->mem == NULL) {
+        return (fputc(data, f->file) == EOF) ? -1 : 0;
+    }
+    if (f->pos < f->mem->size) {
+        f->mem->data[f->pos++] = data;
+        return 0;
+    }
+    return stream_write(f, &data, 1);
+}
+
+static int stream_getc(snapshot_stream_t *f)
+{
+    if (f->mem == NULL) {
+        return fgetc(f->file);
+    }
+    if (f->pos >= f->mem->size) {
+        return EOF;
+    }
+    return f->mem->data[f->pos++];
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int snapshot_write_byte(snapshot_stream_t *f, uint8_t data)
+{
+    current_fpos = stream_tell(f);
+    if (stream_putc(f, data) < 0) {
         snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
         return -1;
     }
@@ -108,9 +231,9 @@ static int snapshot_write_byte(FILE *f, uint8_t data)
     return 0;
 }
 
-static int snapshot_write_word(FILE *f, uint16_t data)
+static int snapshot_write_word(snapshot_stream_t *f, uint16_t data)
 {
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_byte(f, (uint8_t)(data & 0xff)) < 0
         || snapshot_write_byte(f, (uint8_t)(data >> 8)) < 0) {
         return -1;
@@ -119,9 +242,9 @@ static int snapshot_write_word(FILE *f, uint16_t data)
     return 0;
 }
 
-static int snapshot_write_dword(FILE *f, uint32_t data)
+static int snapshot_write_dword(snapshot_stream_t *f, uint32_t data)
 {
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_word(f, (uint16_t)(data & 0xffff)) < 0
         || snapshot_write_word(f, (uint16_t)(data >> 16)) < 0) {
         return -1;
@@ -130,9 +253,9 @@ static int snapshot_write_dword(FILE *f, uint32_t data)
     return 0;
 }
 
-static int snapshot_write_qword(FILE *f, uint64_t data)
+static int snapshot_write_qword(snapshot_stream_t *f, uint64_t data)
 {
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_dword(f, (uint32_t)(data & 0xffffffff)) < 0
         || snapshot_write_dword(f, (uint32_t)(data >> 32)) < 0) {
         return -1;
@@ -141,27 +264,23 @@ static int snapshot_write_qword(FILE *f, uint64_t data)
     return 0;
 }
 
-static int snapshot_write_double(FILE *f, double data)
+static int snapshot_write_double(snapshot_stream_t *f, double data)
 {
-    uint8_t *byte_data = (uint8_t *)&data;
-    int i;
-
-    current_fpos = ftell(f);
-    for (i = 0; i < sizeof(double); i++) {
-        if (snapshot_write_byte(f, byte_data[i]) < 0) {
-            return -1;
-        }
+    current_fpos = stream_tell(f);
+    if (stream_write(f, &data, sizeof(double)) < 0) {
+        snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
+        return -1;
     }
     return 0;
 }
 
-static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char,
+static int snapshot_write_padded_string(snapshot_stream_t *f, const char *s, uint8_t pad_char,
                                         int len)
 {
     int i, found_zero;
     uint8_t c;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = found_zero = 0; i < len; i++) {
         if (!found_zero && s[i] == 0) {
             found_zero = 1;
@@ -175,10 +294,10 @@ static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char
     return 0;
 }
 
-static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int num)
+static int snapshot_write_byte_array(snapshot_stream_t *f, const uint8_t *data, unsigned int num)
 {
-    current_fpos = ftell(f);
-    if (num > 0 && fwrite(data, (size_t)num, 1, f) < 1) {
+    current_fpos = stream_tell(f);
+    if (num > 0 && stream_write(f, data, (size_t)num) < 0) {
         snapshot_error = SNAPSHOT_WRITE_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -186,42 +305,67 @@ static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int
     return 0;
 }
 
-static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int num)
-{
-    unsigned int i;
+/* Word and dword arrays are converted to little endian in chunks of this
+   many bytes, so the stream sees a few bulk writes instead of one call per
+   byte.  */
+#define SNAPSHOT_ARRAY_CHUNK    0x400
 
-    current_fpos = ftell(f);
-    for (i = 0; i < num; i++) {
-        if (snapshot_write_word(f, data[i]) < 0) {
+static int snapshot_write_word_array(snapshot_stream_t *f, const uint16_t *data, unsigned int num)
+{
+    uint8_t buf[SNAPSHOT_ARRAY_CHUNK];
+    unsigned int i, n;
+
+    current_fpos = stream_tell(f);
+    while (num > 0) {
+        n = (num > SNAPSHOT_ARRAY_CHUNK / 2) ? SNAPSHOT_ARRAY_CHUNK / 2 : num;
+        for (i = 0; i < n; i++) {
+            buf[i * 2] = (uint8_t)(data[i] & 0xff);
+            buf[i * 2 + 1] = (uint8_t)(data[i] >> 8);
+        }
+        if (stream_write(f, buf, n * 2) < 0) {
+            snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
             return -1;
         }
+        data += n;
+        num -= n;
     }
 
     return 0;
 }
 
-static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned int num)
+static int snapshot_write_dword_array(snapshot_stream_t *f, const uint32_t *data, unsigned int num)
 {
-    unsigned int i;
-
-    current_fpos = ftell(f);
-    for (i = 0; i < num; i++) {
-        if (snapshot_write_dword(f, data[i]) < 0) {
+    uint8_t buf[SNAPSHOT_ARRAY_CHUNK];
+    unsigned int i, n;
+
+    current_fpos = stream_tell(f);
+    while (num > 0) {
+        n = (num > SNAPSHOT_ARRAY_CHUNK / 4) ? SNAPSHOT_ARRAY_CHUNK / 4 : num;
+        for (i = 0; i < n; i++) {
+            buf[i * 4] = (uint8_t)(data[i] & 0xff);
+            buf[i * 4 + 1] = (uint8_t)((data[i] >> 8) & 0xff);
+            buf[i * 4 + 2] = (uint8_t)((data[i] >> 16) & 0xff);
+            buf[i * 4 + 3] = (uint8_t)(data[i] >> 24);
+        }
+        if (stream_write(f, buf, n * 4) < 0) {
+            snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
             return -1;
         }
+        data += n;
+        num -= n;
     }
 
     return 0;
 }
 
 
-static int snapshot_write_string(FILE *f, const char *s)
+static int snapshot_write_string(snapshot_stream_t *f, const char *s)
 {
     size_t len, i;
 
     len = s ? (strlen(s) + 1) : 0;      /* length includes nullbyte */
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_word(f, (uint16_t)len) < 0) {
         return -1;
     }
@@ -235,12 +379,12 @@ static int snapshot_write_string(FILE *f, const char *s)
     return (int)(len + sizeof(uint16_t));
 }
 
-static int snapshot_read_byte(FILE *f, uint8_t *b_return)
+static int snapshot_read_byte(snapshot_stream_t *f, uint8_t *b_return)
 {
     int c;
 
-    current_fpos = ftell(f);
-    c = fgetc(f);
+    current_fpos = stream_tell(f);
+    c = stream_getc(f);
     if (c == EOF) {
         snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
@@ -249,11 +393,11 @@ static int snapshot_read_byte(FILE *f, uint8_t *b_return)
     return 0;
 }
 
-static int snapshot_read_word(FILE *f, uint16_t *w_return)
+static int snapshot_read_word(snapshot_stream_t *f, uint16_t *w_return)
 {
     uint8_t lo, hi;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_byte(f, &lo) < 0 || snapshot_read_byte(f, &hi) < 0) {
         return -1;
     }
@@ -262,11 +406,11 @@ static int snapshot_read_word(FILE *f, uint16_t *w_return)
     return 0;
 }
 
-static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
+static int snapshot_read_dword(snapshot_stream_t *f, uint32_t *dw_return)
 {
     uint16_t lo, hi;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_word(f, &lo) < 0 || snapshot_read_word(f, &hi) < 0) {
         return -1;
     }
@@ -275,11 +419,11 @@ static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
     return 0;
 }
 
-static int snapshot_read_qword(FILE *f, uint64_t *qw_return)
+static int snapshot_read_qword(snapshot_stream_t *f, uint64_t *qw_return)
 {
     uint32_t lo, hi;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_dword(f, &lo) < 0 || snapshot_read_dword(f, &hi) < 0) {
         return -1;
     }
@@ -288,30 +432,23 @@ static int snapshot_read_qword(FILE *f, uint64_t *qw_return)
     return 0;
 }
 
-static int snapshot_read_double(FILE *f, double *d_return)
+static int snapshot_read_double(snapshot_stream_t *f, double *d_return)
 {
-    int i;
-    int c;
     double val;
-    uint8_t *byte_val = (uint8_t *)&val;
 
-    current_fpos = ftell(f);
-    for (i = 0; i < sizeof(double); i++) {
-        c = fgetc(f);
-        if (c == EOF) {
-            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
-            return -1;
-        }
-        byte_val[i] = (uint8_t)c;
+    current_fpos = stream_tell(f);
+    if (stream_read(f, &val, sizeof(double)) < 0) {
+        snapshot_error = SNAPSHOT_READ_EOF_ERROR;
+        return -1;
     }
     *d_return = val;
     return 0;
 }
 
-static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num)
+static int snapshot_read_byte_array(snapshot_stream_t *f, uint8_t *b_return, unsigned int num)
 {
-    current_fpos = ftell(f);
-    if (num > 0 && fread(b_return, (size_t)num, 1, f) < 1) {
+    current_fpos = stream_tell(f);
+    if (num > 0 && stream_read(f, b_return, (size_t)num) < 0) {
         snapshot_error = SNAPSHOT_READ_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -319,35 +456,54 @@ static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num
     return 0;
 }
 
-static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int num)
+static int snapshot_read_word_array(snapshot_stream_t *f, uint16_t *w_return, unsigned int num)
 {
-    unsigned int i;
+    uint8_t buf[SNAPSHOT_ARRAY_CHUNK];
+    unsigned int i, n;
 
-    current_fpos = ftell(f);
-    for (i = 0; i < num; i++) {
-        if (snapshot_read_word(f, w_return + i) < 0) {
+    current_fpos = stream_tell(f);
+    while (num > 0) {
+        n = (num > SNAPSHOT_ARRAY_CHUNK / 2) ? SNAPSHOT_ARRAY_CHUNK / 2 : num;
+        if (stream_read(f, buf, n * 2) < 0) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
             return -1;
         }
+        for (i = 0; i < n; i++) {
+            w_return[i] = (uint16_t)(buf[i * 2] | (buf[i * 2 + 1] << 8));
+        }
+        w_return += n;
+        num -= n;
     }
 
     return 0;
 }
 
-static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int num)
+static int snapshot_read_dword_array(snapshot_stream_t *f, uint32_t *dw_return, unsigned int num)
 {
-    unsigned int i;
+    uint8_t buf[SNAPSHOT_ARRAY_CHUNK];
+    unsigned int i, n;
 
-    current_fpos = ftell(f);
-    for (i = 0; i < num; i++) {
-        if (snapshot_read_dword(f, dw_return + i) < 0) {
+    current_fpos = stream_tell(f);
+    while (num > 0) {
+        n = (num > SNAPSHOT_ARRAY_CHUNK / 4) ? SNAPSHOT_ARRAY_CHUNK / 4 : num;
+        if (stream_read(f, buf, n * 4) < 0) {
+            snapshot_error = SNAPSHOT_READ_EOF_ERROR;
             return -1;
         }
+        for (i = 0; i < n; i++) {
+            dw_return[i] = (uint32_t)buf[i * 4]
+                           | ((uint32_t)buf[i * 4 + 1] << 8)
+                           | ((uint32_t)buf[i * 4 + 2] << 16)
+                           | ((uint32_t)buf[i * 4 + 3] << 24);
+        }
+        dw_return += n;
+        num -= n;
     }
 
     return 0;
 }
 
-static int snapshot_read_string(FILE *f, char **s)
+static int snapshot_read_string(snapshot_stream_t *f, char **s)
 {
     int i, len;
     uint16_t w;
@@ -357,7 +513,7 @@ static int snapshot_read_string(FILE *f, char **s)
     lib_free(*s);
     *s = NULL;      /* don't leave a bogus pointer */
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_word(f, &w) < 0) {
         return -1;
     }
@@ -488,8 +644,8 @@ int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 
 int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -499,8 +655,8 @@ int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 
 int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -510,8 +666,8 @@ int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 
 int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -521,8 +677,8 @@ int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 
 int snapshot_module_read_qword(snapshot_module_t *m, uint64_t *qw_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint64_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint64_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -532,8 +688,8 @@ int snapshot_module_read_qword(snapshot_module_t *m, uint64_t *qw_return)
 
 int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(double) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(double) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -543,8 +699,8 @@ int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 
 int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
 {
-    current_fpos = ftell(m->file);
-    if ((long)(ftell(m->file) + num) > (long)(m->offset + m->size)) {
+    current_fpos = stream_tell(m->file);
+    if ((long)(stream_tell(m->file) + num) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -554,7 +710,7 @@ int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, uns
 
 int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
+    if ((long)(stream_tell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -564,8 +720,8 @@ int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, un
 
 int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return, unsigned int num)
 {
-    current_fpos = ftell(m->file);
-    if ((long)(ftell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
+    current_fpos = stream_tell(m->file);
+    if ((long)(stream_tell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -575,8 +731,8 @@ int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return,
 
 int snapshot_module_read_string(snapshot_module_t *m, char **charp_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -681,8 +837,8 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
     current_module = (char *)name;
 
     m = lib_malloc(sizeof(snapshot_module_t));
-    m->file = s->file;
-    m->offset = ftell(s->file);
+    m->file = &s->stream;
+    m->offset = stream_tell(&s->stream);
     if (m->offset == -1) {
         snapshot_error = SNAPSHOT_ILLEGAL_OFFSET_ERROR;
         lib_free(m);
@@ -690,15 +846,15 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
     }
     m->write_mode = 1;
 
-    if (snapshot_write_padded_string(s->file, name, (uint8_t)0, SNAPSHOT_MODULE_NAME_LEN) < 0
-        || snapshot_write_byte(s->file, major_version) < 0
-        || snapshot_write_byte(s->file, minor_version) < 0
-        || snapshot_write_dword(s->file, 0) < 0) {
+    if (snapshot_write_padded_string(&s->stream, name, (uint8_t)0, SNAPSHOT_MODULE_NAME_LEN) < 0
+        || snapshot_write_byte(&s->stream, major_version) < 0
+        || snapshot_write_byte(&s->stream, minor_version) < 0
+        || snapshot_write_dword(&s->stream, 0) < 0) {
         return NULL;
     }
 
-    m->size = (uint32_t)(ftell(s->file) - m->offset);
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size = (uint32_t)(stream_tell(&s->stream) - m->offset);
+    m->size_offset = stream_tell(&s->stream) - sizeof(uint32_t);
 
     return m;
 }
@@ -711,14 +867,14 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
 
     current_module = (char *)name;
 
-    if (fseek(s->file, s->first_module_offset, SEEK_SET) < 0) {
+    if (stream_seek(&s->stream, s->first_module_offset) < 0) {
         snapshot_error = SNAPSHOT_FIRST_MODULE_NOT_FOUND_ERROR;
         DBG(("snapshot_module_open error: name: '%s' NOT found\n", name));
         return NULL;
     }
 
     m = lib_malloc(sizeof(snapshot_module_t));
-    m->file = s->file;
+    m->file = &s->stream;
     m->write_mode = 0;
 
     m->offset = s->first_module_offset;
@@ -728,11 +884,11 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
     /* Search for the module name.  This is quite inefficient, but I don't
        think we care.  */
     while (1) {
-        if (snapshot_read_byte_array(s->file, (uint8_t *)n,
+        if (snapshot_read_byte_array(&s->stream, (uint8_t *)n,
                                      SNAPSHOT_MODULE_NAME_LEN) < 0
-            || snapshot_read_byte(s->file, major_version_return) < 0
-            || snapshot_read_byte(s->file, minor_version_return) < 0
-            || snapshot_read_dword(s->file, &m->size)) {
+            || snapshot_read_byte(&s->stream, major_version_return) < 0
+            || snapshot_read_byte(&s->stream, minor_version_return) < 0
+            || snapshot_read_dword(&s->stream, &m->size)) {
             snapshot_error = SNAPSHOT_MODULE_HEADER_READ_ERROR;
             goto fail;
         }
@@ -744,13 +900,13 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
         }
 
         m->offset += m->size;
-        if (fseek(s->file, m->offset, SEEK_SET) < 0) {
+        if (stream_seek(&s->stream, m->offset) < 0) {
             snapshot_error = SNAPSHOT_MODULE_NOT_FOUND_ERROR;
             goto fail;
         }
     }
 
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size_offset = stream_tell(&s->stream) - sizeof(uint32_t);
 #if 0
     /* HACK: if any of the errors *this* function can produce is still pending
              in snapshot_error, clear it out - else we might fail for no reason
@@ -766,7 +922,7 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
     return m;
 
 fail:
-    fseek(s->file, s->first_module_offset, SEEK_SET);
+    stream_seek(&s->stream, s->first_module_offset);
     lib_free(m);
     DBG(("snapshot_module_open error: name: '%s' NOT found\n", name));
     return NULL;
@@ -777,7 +933,7 @@ int snapshot_module_close(snapshot_module_t *m)
     DBG(("snapshot_module_close name: '%s'\n", current_module));
     /* Backpatch module size if writing.  */
     if (m->write_mode
-        && (fseek(m->file, m->size_offset, SEEK_SET) < 0
+        && (stream_seek(m->file, m->size_offset) < 0
             || snapshot_write_dword(m->file, m->size) < 0)) {
         snapshot_error = SNAPSHOT_MODULE_CLOSE_ERROR;
         DBG(("snapshot_module_close error\n"));
@@ -785,7 +941,7 @@ int snapshot_module_close(snapshot_module_t *m)
     }
 
     /* Skip module.  */
-    if (fseek(m->file, m->offset + m->size, SEEK_SET) < 0) {
+    if (stream_seek(m->file, m->offset + m->size) < 0) {
         snapshot_error = SNAPSHOT_MODULE_SKIP_ERROR;
         DBG(("snapshot_module_close error\n"));
         return -1;
@@ -800,16 +956,26 @@ int snapshot_module_close(snapshot_module_t *m)
 
 snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
 {
-    FILE *f;
+    snapshot_stream_t stream;
+    snapshot_stream_t *f = &stream;
     snapshot_t *s;
     unsigned char viceversion[4] = { VERSION_RC_NUMBER };
 
-    current_filename = (char *)filename;
+    f->file = NULL;
+    f->mem = selected_memory;
+    f->pos = 0;
 
-    f = fopen(filename, MODE_WRITE);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
-        return NULL;
+    if (f->mem != NULL) {
+        current_filename = "(memory)";
+        f->mem->size = 0;
+    } else {
+        current_filename = (char *)filename;
+
+        f->file = fopen(filename, MODE_WRITE);
+        if (f->file == NULL) {
+            snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
+            return NULL;
+        }
     }
 
     /* Magic string.  */
@@ -851,15 +1017,17 @@ snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t
     }
 
     s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
-    s->first_module_offset = ftell(f);
+    s->stream = stream;
+    s->first_module_offset = stream_tell(f);
     s->write_mode = 1;
 
     return s;
 
 fail:
-    fclose(f);
-    archdep_remove(filename);
+    if (f->file != NULL) {
+        fclose(f->file);
+        archdep_remove(filename);
+    }
     return NULL;
 }
 
@@ -869,20 +1037,30 @@ static uint32_t snapshot_vicerevision;
 
 snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
 {
-    FILE *f;
+    snapshot_stream_t stream;
+    snapshot_stream_t *f = &stream;
     char magic[SNAPSHOT_MAGIC_LEN];
     snapshot_t *s = NULL;
     int machine_name_len;
     size_t offs;
 
     current_machine_name = (char *)snapshot_machine_name;
-    current_filename = (char *)filename;
     current_module = NULL;
 
-    f = zfile_fopen(filename, MODE_READ);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
-        return NULL;
+    f->file = NULL;
+    f->mem = selected_memory;
+    f->pos = 0;
+
+    if (f->mem != NULL) {
+        current_filename = "(memory)";
+    } else {
+        current_filename = (char *)filename;
+
+        f->file = zfile_fopen(filename, MODE_READ);
+        if (f->file == NULL) {
+            snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
+            return NULL;
+        }
     }
 
     /* Magic string.  */
@@ -917,12 +1095,12 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
     /* VICE version and revision */
     memset(snapshot_viceversion, 0, 4);
     snapshot_vicerevision = 0;
-    offs = ftell(f);
+    offs = stream_tell(f);
 
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_VERSION_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_version_magic_string, SNAPSHOT_VERSION_MAGIC_LEN) != 0) {
         /* old snapshots do not contain VICE version */
-        fseek(f, offs, SEEK_SET);
+        stream_seek(f, offs);
         log_warning(LOG_DEFAULT, "attempting to load pre 2.4.30 snapshot");
     } else {
         /* actually read the version */
@@ -937,15 +1115,17 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
     }
 
     s = lib_malloc(sizeof(snapshot_t));
-    s->file = f;
-    s->first_module_offset = ftell(f);
+    s->stream = stream;
+    s->first_module_offset = stream_tell(f);
     s->write_mode = 0;
 
     vsync_suspend_speed_eval();
     return s;
 
 fail:
-    fclose(f);
+    if (f->file != NULL) {
+        fclose(f->file);
+    }
     return NULL;
 }
 
@@ -953,15 +1133,18 @@ int snapshot_close(snapshot_t *s)
 {
     int retval;
 
-    if (!s->write_mode) {
-        if (zfile_fclose(s->file) == EOF) {
+    if (s->stream.mem != NULL) {
+        /* Nothing to close, the data stays in the memory buffer.  */
+        retval = 0;
+    } else if (!s->write_mode) {
+        if (zfile_fclose(s->stream.file) == EOF) {
             snapshot_error = SNAPSHOT_READ_CLOSE_EOF_ERROR;
             retval = -1;
         } else {
             retval = 0;
         }
     } else {
-        if (fclose(s->file) == EOF) {
+        if (fclose(s->stream.file) == EOF) {
             snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
             retval = -1;
         } else {
@@ -973,6 +1156,53 @@ int snapshot_close(snapshot_t *s)
     return retval;
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Create a new, empty memory snapshot buffer.  */
+snapshot_memory_t *snapshot_memory_new(void)
+{
+    return lib_calloc(1, sizeof(snapshot_memory_t));
+}
+
+void snapshot_memory_destroy(snapshot_memory_t *mem)
+{
+    if (mem == NULL) {
+        return;
+    }
+    if (mem == selected_memory) {
+        selected_memory = NULL;
+    }
+    lib_free(mem->data);
+    lib_free(mem);
+}
+
+/* Make the following snapshot_create()/snapshot_open() calls use `mem'
+   instead of a file, or go back to files if `mem' is NULL.  */
+void snapshot_memory_select(snapshot_memory_t *mem)
+{
+    selected_memory = mem;
+}
+
+/* Return the snapshot data held in `mem', its size is stored in `size'.  */
+const uint8_t *snapshot_memory_get_data(snapshot_memory_t *mem, size_t *size)
+{
+    *size = mem->size;
+    return mem->data;
+}
+
+/* Replace the contents of `mem' with a copy of `data'.  */
+void snapshot_memory_set_data(snapshot_memory_t *mem, const uint8_t *data, size_t size)
+{
+    if (size > mem->alloc) {
+        mem->data = lib_realloc(mem->data, size);
+        mem->alloc = size;
+    }
+    if (size > 0) {
+        memcpy(mem->data, data, size);
+    }
+    mem->size = size;
+}
+
 static void display_error_with_vice_version(char *text, char *filename)
 {
     char *vmessage = lib_malloc(0x100);
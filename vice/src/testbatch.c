@@ -0,0 +1,554 @@
+/*
+ * testbatch.c - Run many test programs in one emulator process.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+
+/* `-testbatch <list>' runs every program named in <list> in turn and
+   reports how each one ended.  The list holds one program per line,
+   optionally followed by the number of cycles it may run; empty lines and
+   lines starting with `#' are ignored.
+
+   The machine is booted once and a snapshot of it is kept in memory.  Each
+   test restores that snapshot, injects the program into RAM and types RUN,
+   so a test costs no process start, ROM loading or KERNAL reset.  A test
+   ends when the program writes its exit code to the debug cartridge or when
+   its cycle limit is reached; the exit code, the cycles used and a CRC32 of
+   the screen at the end of that frame are recorded.
+
+   With `-testbatchjobs <n>' the booted process forks into n workers which
+   each run every n-th test.  The results are printed in list order as CSV
+   on stdout once all tests are done.  Builds that run the emulation on its
+   own thread (USE_VICE_THREAD) cannot fork safely and run all tests in one
+   process.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIX_COMPILE
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "archdep.h"
+#include "autostart-prg.h"
+#include "cmdline.h"
+#include "fileio.h"
+#include "interrupt.h"
+#include "kbdbuf.h"
+#include "lib.h"
+#include "log.h"
+#include "machine-video.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "screenshot.h"
+#include "snapshot.h"
+#include "types.h"
+
+#include "testbatch.h"
+
+/* Seconds of emulated time to let the machine boot before the snapshot
+   all tests start from is taken, enough for all KERNALs to reach READY.  */
+#define TESTBATCH_BOOT_SECONDS      3
+
+/* Cycle limit of tests that do not give one, unless -limitcycles is used.  */
+#define TESTBATCH_DEFAULT_LIMIT     100000000
+
+/* Maximum length of a line in the test list.  */
+#define TESTBATCH_LINE_MAX          1024
+
+/* Test results other than a debug cartridge exit code.  */
+#define TESTBATCH_TIMEOUT           -1
+#define TESTBATCH_ERROR             -2
+
+typedef struct testbatch_test_s {
+    char *program;
+    CLOCK limit;
+
+    /* Debug cartridge exit code, TESTBATCH_TIMEOUT or TESTBATCH_ERROR.  */
+    int result;
+
+    /* Cycles from the start of the test to its end.  */
+    CLOCK cycles;
+
+    /* CRC32 of the screen at the end of the test.  */
+    uint32_t screen_crc;
+} testbatch_test_t;
+
+enum {
+    TESTBATCH_IDLE,     /* no batch requested, or finished */
+    TESTBATCH_BOOTING,  /* waiting for the machine to boot */
+    TESTBATCH_RUNNING,  /* a test is running */
+    TESTBATCH_STOPPED,  /* a test has ended, waiting for the end of the frame */
+    TESTBATCH_SWITCHING /* waiting for the trap that starts the next test */
+};
+
+static log_t testbatch_log = LOG_DEFAULT;
+
+/* Command line settings.  */
+static char *testbatch_list_name = NULL;
+static int testbatch_jobs = 1;
+
+static testbatch_test_t *tests = NULL;
+static int num_tests = 0;
+
+static int state = TESTBATCH_IDLE;
+
+/* Tests of this process are `current', `current + step', ...  */
+static int current = 0;
+static int step = 1;
+
+/* Snapshot of the booted machine.  */
+static snapshot_memory_t *boot_snapshot = NULL;
+
+static CLOCK test_start_clk;
+
+/* Wall time spent running the tests of this process.  */
+static uint64_t elapsed_ticks = 0;
+static tick_t last_tick;
+
+#ifdef UNIX_COMPILE
+/* Result file of a worker process, NULL in the main process.  */
+static FILE *worker_results = NULL;
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Read the test list, return -1 if it can not be read or is empty.  */
+static int testbatch_read_list(const char *path, CLOCK default_limit)
+{
+    FILE *fp;
+    char buffer[TESTBATCH_LINE_MAX];
+    int size = 0;
+
+    fp = fopen(path, MODE_READ_TEXT);
+    if (fp == NULL) {
+        log_error(testbatch_log, "Cannot open test list `%s'.", path);
+        return -1;
+    }
+
+    while (fgets(buffer, sizeof buffer, fp) != NULL) {
+        char *s = buffer;
+        char *limit;
+        size_t len;
+
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        len = strlen(s);
+        while (len > 0 && (s[len - 1] == '\n' || s[len - 1] == '\r'
+                    || s[len - 1] == ' ' || s[len - 1] == '\t')) {
+            s[--len] = '\0';
+        }
+        if (len == 0 || *s == '#') {
+            continue;
+        }
+        if (num_tests == size) {
+            size = size == 0 ? 64 : size * 2;
+            tests = lib_realloc(tests, sizeof *tests * (size_t)size);
+        }
+        memset(&tests[num_tests], 0, sizeof *tests);
+        tests[num_tests].limit = default_limit;
+
+        /* a trailing number is the cycle limit */
+        limit = strrchr(s, ' ');
+        if (limit == NULL) {
+            limit = strrchr(s, '\t');
+        }
+        if (limit != NULL && strspn(limit + 1, "0123456789") == strlen(limit + 1)) {
+            tests[num_tests].limit = (CLOCK)strtoull(limit + 1, NULL, 10);
+            while (limit > s && (limit[-1] == ' ' || limit[-1] == '\t')) {
+                limit--;
+            }
+            *limit = '\0';
+        }
+        tests[num_tests].program = lib_strdup(s);
+        num_tests++;
+    }
+    fclose(fp);
+
+    if (num_tests == 0) {
+        log_error(testbatch_log, "No tests in `%s'.", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void testbatch_free_list(void)
+{
+    int i;
+
+    for (i = 0; i < num_tests; i++) {
+        lib_free(tests[i].program);
+    }
+    lib_free(tests);
+    tests = NULL;
+    num_tests = 0;
+}
+
+/* Put the program of test `n' into the booted machine and type RUN.  */
+static int testbatch_load(int n)
+{
+    fileio_info_t *finfo;
+    int result;
+
+    if (machine_read_snapshot_memory(boot_snapshot, 0) < 0) {
+        log_error(testbatch_log, "Cannot restore the machine for `%s'.", tests[n].program);
+        snapshot_set_error(SNAPSHOT_NO_ERROR);
+        return -1;
+    }
+
+    finfo = fileio_open(tests[n].program, NULL, FILEIO_FORMAT_RAW | FILEIO_FORMAT_P00,
+                        FILEIO_COMMAND_READ | FILEIO_COMMAND_FSNAME,
+                        FILEIO_TYPE_PRG, NULL);
+    if (finfo == NULL) {
+        log_error(testbatch_log, "Cannot open `%s'.", tests[n].program);
+        return -1;
+    }
+    result = autostart_prg_with_ram_injection(tests[n].program, finfo, testbatch_log);
+    fileio_close(finfo);
+
+    if (result < 0 || autostart_prg_perform_injection(testbatch_log) < 0) {
+        return -1;
+    }
+    kbdbuf_feed("RUN\r");
+
+    return 0;
+}
+
+/* Write the CSV report of all tests to stdout, return the exit code of the
+   batch: 0 if all tests passed.  */
+static int testbatch_report(uint64_t ticks, int jobs)
+{
+    int i, passed = 0, failed = 0, timeouts = 0, errors = 0;
+    double seconds = (double)ticks / tick_per_second();
+
+    printf("program,result,exitcode,cycles,screencrc\n");
+    for (i = 0; i < num_tests; i++) {
+        testbatch_test_t *t = &tests[i];
+        const char *result;
+
+        if (t->result == TESTBATCH_ERROR) {
+            printf("%s,error,,,\n", t->program);
+            errors++;
+            continue;
+        }
+        if (t->result == TESTBATCH_TIMEOUT) {
+            result = "timeout";
+            timeouts++;
+        } else if (t->result == 0) {
+            result = "pass";
+            passed++;
+        } else {
+            result = "fail";
+            failed++;
+        }
+        printf("%s,%s,", t->program, result);
+        if (t->result >= 0) {
+            printf("%d", t->result);
+        }
+        printf(",%"PRIu64",%08x\n", (uint64_t)t->cycles, (unsigned int)t->screen_crc);
+    }
+    fflush(stdout);
+
+    log_message(testbatch_log, "%d tests in %.1f s with %d job(s), %.0f tests/minute: "
+                "%d passed, %d failed, %d timed out, %d not run.",
+                num_tests, seconds, jobs, seconds > 0.0 ? num_tests * 60.0 / seconds : 0.0,
+                passed, failed, timeouts, errors);
+
+    return (passed == num_tests) ? 0 : 1;
+}
+
+/* Start test `current' or, if none are left, end this process.  Tests that
+   can not be loaded are skipped.  */
+static void testbatch_next(void)
+{
+    for (; current < num_tests; current += step) {
+        if (testbatch_load(current) == 0) {
+            test_start_clk = maincpu_clk;
+            state = TESTBATCH_RUNNING;
+            return;
+        }
+        tests[current].result = TESTBATCH_ERROR;
+#ifdef UNIX_COMPILE
+        if (worker_results != NULL) {
+            fprintf(worker_results, "%d 0 0\n", TESTBATCH_ERROR);
+        }
+#endif
+    }
+
+    state = TESTBATCH_IDLE;
+    elapsed_ticks += tick_now_delta(last_tick);
+
+#ifdef UNIX_COMPILE
+    if (worker_results != NULL) {
+        /* the last line holds the time taken by this worker */
+        fprintf(worker_results, "%"PRIu64"\n", elapsed_ticks);
+        fflush(worker_results);
+        _exit(0);
+    }
+#endif
+    archdep_vice_exit(testbatch_report(elapsed_ticks, 1));
+}
+
+/* Record the end of the running test and start the next one.  */
+static void testbatch_end_trap(uint16_t addr, void *data)
+{
+    testbatch_test_t *t = &tests[current];
+
+    if (screenshot_crc32(machine_video_canvas_get(0), &t->screen_crc) < 0) {
+        t->screen_crc = 0;
+    }
+#ifdef UNIX_COMPILE
+    if (worker_results != NULL) {
+        fprintf(worker_results, "%d %"PRIu64" %u\n", t->result,
+                (uint64_t)t->cycles, (unsigned int)t->screen_crc);
+    }
+#endif
+    current += step;
+    testbatch_next();
+}
+
+/* Record how the running test ended.  The screen is checked at the end of
+   the frame, so what the program printed last is on it.  */
+static void testbatch_stop(int result)
+{
+    tests[current].result = result;
+    tests[current].cycles = maincpu_clk - test_start_clk;
+    state = TESTBATCH_STOPPED;
+}
+
+#ifdef UNIX_COMPILE
+/* Run the tests in `jobs' worker processes and exit with the combined
+   report.  Returns if no worker could be started.  */
+static void testbatch_fork_workers(int jobs)
+{
+    FILE **results = lib_calloc((size_t)jobs, sizeof *results);
+    pid_t *pids = lib_calloc((size_t)jobs, sizeof *pids);
+    uint64_t ticks = 0, worker_ticks;
+    int workers, i;
+
+    fflush(stdout);
+    fflush(stderr);
+    for (workers = 0; workers < jobs; workers++) {
+        results[workers] = tmpfile();
+        if (results[workers] == NULL) {
+            break;
+        }
+        pids[workers] = fork();
+        if (pids[workers] < 0) {
+            fclose(results[workers]);
+            results[workers] = NULL;
+            break;
+        }
+        if (pids[workers] == 0) {
+            /* worker: continue the emulation with every n-th test */
+            worker_results = results[workers];
+            current = workers;
+            step = jobs;
+            lib_free(results);
+            lib_free(pids);
+            return;
+        }
+    }
+
+    if (workers == 0) {
+        log_warning(testbatch_log, "Cannot start worker processes, running the tests here.");
+        lib_free(results);
+        lib_free(pids);
+        return;
+    }
+    if (workers < jobs) {
+        log_warning(testbatch_log, "Only %d of %d worker processes started, "
+                    "the tests of the others are not run.", workers, jobs);
+    }
+
+    for (i = 0; i < workers; i++) {
+        waitpid(pids[i], NULL, 0);
+        rewind(results[i]);
+    }
+    for (i = 0; i < num_tests; i++) {
+        testbatch_test_t *t = &tests[i];
+        uint64_t cycles;
+        unsigned int crc;
+
+        if (i % jobs >= workers) {
+            t->result = TESTBATCH_ERROR;
+            continue;
+        }
+        if (fscanf(results[i % jobs], "%d %"SCNu64" %u", &t->result, &cycles, &crc) != 3) {
+            /* the worker died */
+            t->result = TESTBATCH_ERROR;
+            continue;
+        }
+        t->cycles = (CLOCK)cycles;
+        t->screen_crc = crc;
+    }
+    for (i = 0; i < workers; i++) {
+        if (fscanf(results[i], "%"SCNu64, &worker_ticks) == 1 && worker_ticks > ticks) {
+            ticks = worker_ticks;
+        }
+        fclose(results[i]);
+    }
+    lib_free(results);
+    lib_free(pids);
+
+    archdep_vice_exit(testbatch_report(ticks, workers));
+}
+#endif
+
+/* Take the snapshot of the booted machine and start the tests.  */
+static void testbatch_start_trap(uint16_t addr, void *data)
+{
+    int jobs = testbatch_jobs;
+
+    boot_snapshot = snapshot_memory_new();
+    if (machine_write_snapshot_memory(boot_snapshot, 0, 0, 0) < 0) {
+        log_error(testbatch_log, "Cannot take a snapshot of the booted machine.");
+        archdep_vice_exit(1);
+    }
+
+    if (jobs > num_tests) {
+        jobs = num_tests;
+    }
+#ifdef USE_VICE_THREAD
+    /* the child of a fork() only has the thread that called it, the UI
+       thread and any locks it held would be missing */
+    if (jobs > 1) {
+        log_warning(testbatch_log, "Cannot fork workers with the emulation on its own thread, running the tests in one job.");
+        jobs = 1;
+    }
+#endif
+    log_message(testbatch_log, "Running %d tests from `%s' with %d job(s).",
+                num_tests, testbatch_list_name, jobs);
+
+    last_tick = tick_now();
+#ifdef UNIX_COMPILE
+    if (jobs > 1) {
+        /* returns in the workers only */
+        testbatch_fork_workers(jobs);
+    }
+#endif
+    testbatch_next();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Called once per frame.  */
+void testbatch_vsync_hook(void)
+{
+    switch (state) {
+        case TESTBATCH_IDLE:
+            if (testbatch_list_name == NULL || boot_snapshot != NULL) {
+                return;
+            }
+            /* first frame: the cycle limit of -limitcycles becomes the
+               default limit of each test instead of ending the process */
+            testbatch_log = log_open("TestBatch");
+            if (testbatch_read_list(testbatch_list_name,
+                                    maincpu_clk_limit ? maincpu_clk_limit : TESTBATCH_DEFAULT_LIMIT) < 0) {
+                archdep_vice_exit(1);
+            }
+            maincpu_clk_limit = 0;
+            state = TESTBATCH_BOOTING;
+            break;
+        case TESTBATCH_BOOTING:
+            if (maincpu_clk >= (CLOCK)(TESTBATCH_BOOT_SECONDS * machine_get_cycles_per_second())) {
+                state = TESTBATCH_SWITCHING;
+                interrupt_maincpu_trigger_trap(testbatch_start_trap, NULL);
+            }
+            break;
+        case TESTBATCH_RUNNING:
+            if (maincpu_clk - test_start_clk < tests[current].limit) {
+                break;
+            }
+            testbatch_stop(TESTBATCH_TIMEOUT);
+            /* fall through */
+        case TESTBATCH_STOPPED:
+            state = TESTBATCH_SWITCHING;
+            interrupt_maincpu_trigger_trap(testbatch_end_trap, NULL);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Called by the debug cartridge when the program writes its exit code.
+   Returns non-zero if the batch took care of it, the emulator should only
+   exit otherwise.  */
+int testbatch_debugcart_exit(int exit_code)
+{
+    if (state == TESTBATCH_RUNNING) {
+        testbatch_stop(exit_code);
+        return 1;
+    }
+    /* writes between the end of a test and the start of the next */
+    return state != TESTBATCH_IDLE;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int cmdline_testbatch(const char *param, void *extra_param)
+{
+    lib_free(testbatch_list_name);
+    testbatch_list_name = lib_strdup(param);
+    return 0;
+}
+
+static int cmdline_testbatch_jobs(const char *param, void *extra_param)
+{
+    int jobs = atoi(param);
+
+    if (jobs < 1) {
+        return -1;
+    }
+    testbatch_jobs = jobs;
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-testbatch", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_testbatch, NULL, NULL, NULL,
+      "<list>", "Run the programs listed in <list> as tests, one after the other, and report their debug cartridge exit codes" },
+    { "-testbatchjobs", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_testbatch_jobs, NULL, NULL, NULL,
+      "<number>", "Run the tests of -testbatch in <number> worker processes" },
+    CMDLINE_LIST_END
+};
+
+int testbatch_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+void testbatch_shutdown(void)
+{
+    snapshot_memory_destroy(boot_snapshot);
+    boot_snapshot = NULL;
+    testbatch_free_list();
+    lib_free(testbatch_list_name);
+    testbatch_list_name = NULL;
+}
@@ -33,6 +33,7 @@
 #include <string.h>
 
 #include <stdio.h>
+#include "archdep.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -704,6 +705,11 @@ int vdc_dump(void)
 
     mon_out("\nCursor Address : $%04x",
             (unsigned int)(((vdc.regs[14] << 8) + vdc.regs[15]) & vdc.vdc_address_mask));
+    mon_out("\nRender Time    : last frame %u us, max %u us, average %u us over %u timed frames",
+            (unsigned int)TICK_TO_MICRO(vdc.render_ticks_frame),
+            (unsigned int)TICK_TO_MICRO(vdc.render_ticks_max),
+            vdc.render_frames ? (unsigned int)TICK_TO_MICRO(vdc.render_ticks_total / vdc.render_frames) : 0,
+            vdc.render_frames);
     mon_out("\n");
     return 0;
 }
@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "alarm.h"
+#include "archdep.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -321,6 +322,12 @@ void vdc_reset(void)
     }
 
     vdc.frame_counter = 0;
+    vdc.render_sample = 0;
+    vdc.render_ticks = 0;
+    vdc.render_ticks_frame = 0;
+    vdc.render_ticks_max = 0;
+    vdc.render_ticks_total = 0;
+    vdc.render_frames = 0;
     vdc.screen_text_cols = VDC_SCREEN_MAX_TEXTCOLS;
     vdc.xsmooth = 7;
     vdc.regs[0] = 126;
@@ -461,6 +468,22 @@ static void vdc_set_video_mode(void)
     }
 }
 
+/* Close the render time statistics of the frame that just ended and decide
+   whether the next one is timed.  */
+static void vdc_render_stats_end_of_frame(void)
+{
+    if (vdc.render_sample) {
+        vdc.render_ticks_frame = vdc.render_ticks;
+        if (vdc.render_ticks > vdc.render_ticks_max) {
+            vdc.render_ticks_max = vdc.render_ticks;
+        }
+        vdc.render_ticks_total += vdc.render_ticks;
+        vdc.render_frames++;
+    }
+    vdc.render_ticks = 0;
+    vdc.render_sample = (vdc.frame_counter % VDC_RENDER_SAMPLE_FRAMES) == 0;
+}
+
 
 /* Redraw the current raster line. */
 /* This was mostly re-written from scratch in May-June 2019 by Strobe to develop,
@@ -476,6 +499,8 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
     static unsigned int vdc_draw_counter_latch = 0;
     static unsigned int vdc_vert_fine_adj = 0;
     static unsigned int stable_size_count = 0;
+    int render_sample = vdc.render_sample;
+    tick_t render_start = render_sample ? tick_now() : 0;
 
     /*  Video signal handling section ----------------------------------------------------------------------------------------------------------*/
     if (vdc_row_counter_latch) {    /* latch is set if the previous raster line was the last of its character row */
@@ -625,6 +650,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
                 FIXME handle cleanup of remainder of visible raster lines below the reset point somewhere somehow */
             vdc.raster.current_line = 0;
             raster_canvas_handle_end_of_frame(&vdc.raster);
+            vdc_render_stats_end_of_frame();
 
             vdc.frame_counter++;    /* As far as the frame counter is concerned, we are now on a new frame */
 
@@ -846,6 +872,10 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
 
 
     vdc_set_next_alarm(offset);
+
+    if (render_sample) {
+        vdc.render_ticks += tick_now_delta(render_start);
+    }
 }
 
 
@@ -57,6 +57,9 @@
 #define VDC_NUM_SPRITES               0
 #define VDC_NUM_COLORS                16
 
+/* Time the rendering of one frame out of this many */
+#define VDC_RENDER_SAMPLE_FRAMES      32
+
 
 /* VDC Attribute masks */
 #define VDC_FLASH_ATTR              0x10
@@ -154,6 +157,18 @@ struct vdc_s {
     /* Frame counter (required for character blink, cursor blink and interlace) */
     int frame_counter;
 
+    /* Host time spent in the raster line handler, in ticks: for the current
+       frame, the last complete frame, the slowest frame and all frames since
+       the last reset.  Only every VDC_RENDER_SAMPLE_FRAMES-th frame is timed,
+       reading the host clock for every line costs too much.  Shown by the
+       monitor (`io d600').  */
+    int render_sample;
+    uint32_t render_ticks;
+    uint32_t render_ticks_frame;
+    uint32_t render_ticks_max;
+    uint64_t render_ticks_total;
+    unsigned int render_frames;
+
     /* Character attribute blink */
     int attribute_blink;
 
@@ -111,6 +111,323 @@ static unsigned int vdrive_dir_name_match(uint8_t *slot, uint8_t *nslot, int len
     return cbmdos_parse_wildcard_compare(nslot, &slot[SLOT_NAME_OFFSET]);
 }
 
+/* convert date/time into a single 32-bit unsigned value */
+static unsigned int date_to_int(int year, int month, int day, int hour, int minute)
+{
+    unsigned int a;
+
+    /* 7 + 4 + 5 + 5 + 6 = 27 which is < 32 */
+    a = ( 0 << 7 ) | year;
+    a = ( a << 4 ) | month;
+    a = ( a << 5 ) | day;
+    a = ( a << 5 ) | hour;
+    a = ( a << 6 ) | minute;
+
+    return a;
+}
+
+/* Check a directory slot against the name, type and date range searched */
+static int vdrive_dir_slot_match(vdrive_dir_context_t *dir, uint8_t *slot)
+{
+    unsigned int t;
+
+    if (!vdrive_dir_name_match(slot, dir->find_nslot, dir->find_length,
+                               dir->find_type)) {
+        return 0;
+    }
+    /* check date range; for DIR listings */
+    t = date_to_int(slot[SLOT_GEOS_YEAR], slot[SLOT_GEOS_MONTH],
+                    slot[SLOT_GEOS_DATE], slot[SLOT_GEOS_HOUR],
+                    slot[SLOT_GEOS_MINUTE]);
+    /* time_low is initially 0, and time_high is initially largest,
+        so it should always match for most uses. */
+    return t >= dir->time_low && t <= dir->time_high;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/*
+ * Directory index
+ *
+ * Every name lookup used to walk the directory sector chain, which gets slow
+ * on CMD images with thousands of files. The index keeps a copy of the whole
+ * chain of the current directory, plus a hash of the names for lookups
+ * without wildcards. It is built on the first lookup and thrown away as soon
+ * as anything is written to the image (see disk_image_t.generation), or when
+ * another directory, partition or image is selected.
+ */
+
+/* Longest directory chain that is indexed, longer (or looping) chains are
+   walked on disk as before */
+#define VDRIVE_DIR_INDEX_MAX_SECTORS    8192
+
+typedef struct vdrive_dir_index_sector_s {
+    unsigned int track;
+    unsigned int sector;
+    uint8_t data[256];
+} vdrive_dir_index_sector_t;
+
+typedef struct vdrive_dir_index_s {
+    /* what the index was built from */
+    struct disk_image_s *image;
+    unsigned int generation;
+    unsigned int offset;
+    unsigned int format;
+    unsigned int header_track;
+    unsigned int header_sector;
+    unsigned int dir_track;
+    unsigned int dir_sector;
+
+    /* directory sectors in chain order, starting with the header */
+    vdrive_dir_index_sector_t *sectors;
+    unsigned int count;
+
+    /* name hash; entry n is slot (n & 7) of sector (n >> 3), every bucket
+       is in chain order */
+    int *buckets;
+    int *next;
+    uint32_t mask;
+} vdrive_dir_index_t;
+
+void vdrive_dir_index_free(vdrive_t *vdrive)
+{
+    vdrive_dir_index_t *idx = vdrive->dir_index;
+
+    if (idx != NULL) {
+        lib_free(idx->sectors);
+        lib_free(idx->buckets);
+        lib_free(idx->next);
+        lib_free(idx);
+        vdrive->dir_index = NULL;
+    }
+}
+
+/* Hash the part of a name that is compared, the first shifted space ends the
+   name (see cbmdos_parse_wildcard_compare()) */
+static uint32_t vdrive_dir_name_hash(const uint8_t *name)
+{
+    uint32_t hash = 2166136261U;
+    int i;
+
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH && name[i] != 0xa0; i++) {
+        hash = (hash ^ name[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/* Returns non-zero if the name searched for contains no wildcards, so that
+   only slots with the same hash can match */
+static int vdrive_dir_name_is_exact(const vdrive_dir_context_t *dir)
+{
+    int i;
+
+    if (dir->find_length <= 0) {
+        return 0;
+    }
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH && dir->find_nslot[i] != 0xa0; i++) {
+        if (dir->find_nslot[i] == '*' || dir->find_nslot[i] == '?') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Return the index of the current directory, building it if required.
+   Returns NULL if the directory cannot be indexed. */
+static vdrive_dir_index_t *vdrive_dir_index_get(vdrive_t *vdrive)
+{
+    vdrive_dir_index_t *idx = vdrive->dir_index;
+    vdrive_dir_index_sector_t *cur;
+    unsigned int size, entries, n;
+
+    if (vdrive->image == NULL) {
+        return NULL;
+    }
+
+    if (idx != NULL) {
+        if (idx->image == vdrive->image
+            && idx->generation == vdrive->image->generation
+            && idx->offset == vdrive->current_offset
+            && idx->format == vdrive->image_format
+            && idx->header_track == vdrive->Header_Track
+            && idx->header_sector == vdrive->Header_Sector
+            && idx->dir_track == vdrive->Dir_Track
+            && idx->dir_sector == vdrive->Dir_Sector) {
+            return idx;
+        }
+        vdrive_dir_index_free(vdrive);
+    }
+
+    idx = lib_calloc(1, sizeof *idx);
+    idx->image = vdrive->image;
+    idx->generation = vdrive->image->generation;
+    idx->offset = vdrive->current_offset;
+    idx->format = vdrive->image_format;
+    idx->header_track = vdrive->Header_Track;
+    idx->header_sector = vdrive->Header_Sector;
+    idx->dir_track = vdrive->Dir_Track;
+    idx->dir_sector = vdrive->Dir_Sector;
+
+    /* read the chain the same way vdrive_dir_find_next_slot() walks it */
+    size = 16;
+    idx->sectors = lib_malloc(size * sizeof *idx->sectors);
+    cur = &idx->sectors[0];
+    cur->track = vdrive->Header_Track;
+    cur->sector = vdrive->Header_Sector;
+    if (vdrive_read_sector(vdrive, cur->data, cur->track, cur->sector) != 0) {
+        goto fail;
+    }
+    if (vdrive->image_format != VDRIVE_IMAGE_FORMAT_NP) {
+        cur->data[0] = vdrive->Dir_Track;
+        cur->data[1] = vdrive->Dir_Sector;
+    }
+    idx->count = 1;
+
+    while (idx->sectors[idx->count - 1].data[0] != 0) {
+        if (idx->count == VDRIVE_DIR_INDEX_MAX_SECTORS) {
+            goto fail;
+        }
+        if (idx->count == size) {
+            size *= 2;
+            idx->sectors = lib_realloc(idx->sectors, size * sizeof *idx->sectors);
+        }
+        cur = &idx->sectors[idx->count];
+        cur->track = idx->sectors[idx->count - 1].data[0];
+        cur->sector = idx->sectors[idx->count - 1].data[1];
+        if (vdrive_read_sector(vdrive, cur->data, cur->track, cur->sector) != 0) {
+            goto fail;
+        }
+        idx->count++;
+    }
+
+    /* hash the names of all used slots; the header sector is never
+       searched */
+    entries = idx->count * 8;
+    size = 16;
+    while (size < entries) {
+        size <<= 1;
+    }
+    idx->mask = size - 1;
+    idx->buckets = lib_malloc(size * sizeof *idx->buckets);
+    idx->next = lib_malloc(entries * sizeof *idx->next);
+    for (n = 0; n < size; n++) {
+        idx->buckets[n] = -1;
+    }
+    for (n = entries; n-- > 8; ) {
+        uint8_t *slot = &idx->sectors[n >> 3].data[(n & 7) * 32];
+        uint32_t bucket;
+
+        idx->next[n] = -1;
+        if (slot[SLOT_TYPE_OFFSET] == 0) {
+            continue;
+        }
+        bucket = vdrive_dir_name_hash(&slot[SLOT_NAME_OFFSET]) & idx->mask;
+        idx->next[n] = idx->buckets[bucket];
+        idx->buckets[bucket] = (int)n;
+    }
+
+    vdrive->dir_index = idx;
+    return idx;
+
+fail:
+    lib_free(idx->sectors);
+    lib_free(idx);
+    return NULL;
+}
+
+/* Find the next matching slot using the directory index.
+   Returns 1 and positions dir on the slot found, 0 with dir positioned at
+   the end of the directory if there is none, or -1 if the index cannot be
+   used and the directory has to be walked on disk. */
+static int vdrive_dir_index_next(vdrive_dir_context_t *dir)
+{
+    vdrive_dir_index_t *idx;
+    unsigned int k, s, n;
+
+    idx = vdrive_dir_index_get(dir->vdrive);
+    if (idx == NULL) {
+        return -1;
+    }
+
+    /* locate the current sector */
+    k = dir->index_sector;
+    if (k >= idx->count
+        || idx->sectors[k].track != dir->track
+        || idx->sectors[k].sector != dir->sector) {
+        for (k = 0; k < idx->count; k++) {
+            if (idx->sectors[k].track == dir->track
+                && idx->sectors[k].sector == dir->sector) {
+                break;
+            }
+        }
+        if (k == idx->count) {
+            return -1;
+        }
+    }
+
+    /* the rest of the current sector is taken from the buffer, the caller
+       may have changed it */
+    while (++dir->slot < 8) {
+        if (vdrive_dir_slot_match(dir, &dir->buffer[dir->slot * 32])) {
+            dir->index_sector = k;
+            return 1;
+        }
+    }
+    if (dir->buffer[0] == 0) {
+        dir->index_sector = k;
+        return 0;
+    }
+    if (k + 1 >= idx->count
+        || idx->sectors[k + 1].track != dir->buffer[0]
+        || idx->sectors[k + 1].sector != dir->buffer[1]) {
+        return -1;
+    }
+
+    if (vdrive_dir_name_is_exact(dir)) {
+        int e = idx->buckets[vdrive_dir_name_hash(dir->find_nslot) & idx->mask];
+
+        for (; e >= 0; e = idx->next[e]) {
+            n = (unsigned int)e;
+            if ((n >> 3) > k
+                && vdrive_dir_slot_match(dir, &idx->sectors[n >> 3].data[(n & 7) * 32])) {
+                break;
+            }
+        }
+        if (e >= 0) {
+            s = n >> 3;
+            dir->slot = n & 7;
+            goto found;
+        }
+    } else {
+        for (s = k + 1; s < idx->count; s++) {
+            for (n = 0; n < 8; n++) {
+                if (vdrive_dir_slot_match(dir, &idx->sectors[s].data[n * 32])) {
+                    dir->slot = n;
+                    goto found;
+                }
+            }
+        }
+    }
+
+    /* not found, leave dir at the end of the directory */
+    s = idx->count - 1;
+    dir->slot = 8;
+    memcpy(dir->buffer, idx->sectors[s].data, 256);
+    dir->track = idx->sectors[s].track;
+    dir->sector = idx->sectors[s].sector;
+    dir->index_sector = s;
+    return 0;
+
+found:
+    memcpy(dir->buffer, idx->sectors[s].data, 256);
+    dir->track = idx->sectors[s].track;
+    dir->sector = idx->sectors[s].sector;
+    dir->index_sector = s;
+    return 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
 void vdrive_dir_free_chain(vdrive_t *vdrive, int t, int s)
 {
     uint8_t buf[256];
@@ -229,6 +546,7 @@ void vdrive_dir_find_first_slot(vdrive_t *vdrive, const uint8_t *name,
     dir->track = vdrive->Header_Track;
     dir->sector = vdrive->Header_Sector;
     dir->slot = 7;
+    dir->index_sector = 0;
 
     /* date comparisons; show everything */
     dir->time_low = 0;
@@ -247,21 +565,6 @@ void vdrive_dir_find_first_slot(vdrive_t *vdrive, const uint8_t *name,
 #endif
 }
 
-/* convert date/time into a single 32-bit unsigned value */
-static unsigned int date_to_int(int year, int month, int day, int hour, int minute)
-{
-    unsigned int a;
-
-    /* 7 + 4 + 5 + 5 + 6 = 27 which is < 32 */
-    a = ( 0 << 7 ) | year;
-    a = ( a << 4 ) | month;
-    a = ( a << 5 ) | day;
-    a = ( a << 5 ) | hour;
-    a = ( a << 6 ) | minute;
-
-    return a;
-}
-
 uint8_t *vdrive_dir_find_next_slot(vdrive_dir_context_t *dir)
 {
     static uint8_t return_slot[32];
@@ -275,6 +578,16 @@ uint8_t *vdrive_dir_find_next_slot(vdrive_dir_context_t *dir)
     log_debug("DIR: vdrive_dir_find_next_slot start (t:%u/s:%u) #%u",
             dir->track, dir->sector, dir->slot);
 #endif
+    switch (vdrive_dir_index_next(dir)) {
+        case 1:
+            memcpy(return_slot, &dir->buffer[dir->slot * 32], 32);
+            return return_slot;
+        case 0:
+            goto end_of_dir;
+        default:
+            break;
+    }
+
     /*
      * Loop all directory blocks starting from track 18, sector 1 (1541).
      */
@@ -304,21 +617,14 @@ uint8_t *vdrive_dir_find_next_slot(vdrive_dir_context_t *dir)
             }
         }
 
-        if (vdrive_dir_name_match(&dir->buffer[dir->slot * 32],
-                                  dir->find_nslot, dir->find_length,
-                                  dir->find_type)) {
+        if (vdrive_dir_slot_match(dir, &dir->buffer[dir->slot * 32])) {
             memcpy(return_slot, &dir->buffer[dir->slot * 32], 32);
-            /* check date range; for DIR listings */
-            t = date_to_int(return_slot[SLOT_GEOS_YEAR], return_slot[SLOT_GEOS_MONTH],
-                return_slot[SLOT_GEOS_DATE], return_slot[SLOT_GEOS_HOUR],
-                return_slot[SLOT_GEOS_MINUTE] );
-            /* time_low is initially 0, and time_high is initially largest,
-                so it should always match for most uses. */
-            if (t >= dir->time_low && t <= dir->time_high)
-                return return_slot;
+            return return_slot;
         }
     } while (1);
 
+end_of_dir:
+
 #ifdef DEBUG_DRIVE
     log_debug("DIR: vdrive_dir_find_next_slot (t:%u/s:%u) #%u",
             dir->track, dir->sector, dir->slot);
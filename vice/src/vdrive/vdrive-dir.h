@@ -71,10 +71,12 @@ typedef struct vdrive_dir_context_s {
     unsigned int sector;
     unsigned int time_low;
     unsigned int time_high;
+    unsigned int index_sector; /* Position of the current sector in the directory index. */
     struct vdrive_s *vdrive;
 } vdrive_dir_context_t;
 
 void vdrive_dir_init(void);
+void vdrive_dir_index_free(struct vdrive_s *vdrive);
 int vdrive_dir_first_directory(struct vdrive_s *vdrive, struct cbmdos_cmd_parse_plus_s *cmd_parse, struct bufferinfo_s *p);
 int vdrive_dir_next_directory(struct vdrive_s *vdrive, struct bufferinfo_s *b);
 void vdrive_dir_find_first_slot(struct vdrive_s *vdrive, const uint8_t *name, int length, unsigned int type, vdrive_dir_context_t *dir);
@@ -68,6 +68,7 @@ vdrive_t *vdrive_internal_open_fsimage(const char *name, unsigned int read_only)
     image->p64 = lib_calloc(1, sizeof(TP64Image));
     P64ImageCreate((void*)image->p64);
     image->read_only = read_only;
+    image->generation = 0;
 
     image->device = DISK_IMAGE_DEVICE_FS;
 
@@ -176,7 +176,9 @@ void vdrive_device_shutdown(vdrive_t *vdrive)
             p = &(vdrive->buffers[i]);
             vdrive_free_buffer(p);
             lib_free(p->buffer);
+            p->buffer = NULL;
         }
+        vdrive_dir_index_free(vdrive);
     }
 }
 
@@ -348,6 +350,7 @@ void vdrive_detach_image(disk_image_t *image, unsigned int unit,
     }
 
     disk_image_detach_log(image, vdrive_log, unit, drive);
+    vdrive_dir_index_free(vdrive);
 
     /* shutdown everything on that drive */
     if (vdrive->haspt) {
@@ -421,6 +424,7 @@ int vdrive_attach_image(disk_image_t *image, unsigned int unit,
     }
 
     disk_image_attach_log(image, vdrive_log, unit, drive);
+    vdrive_dir_index_free(vdrive);
 
     /* fix the number of tracks here as extended tracks aren't supported */
     switch (image->type) {
@@ -131,6 +131,7 @@ typedef struct bufferinfo_s {
 } bufferinfo_t;
 
 struct disk_image_s;
+struct vdrive_dir_index_s;
 
 /* Run-time data struct for each drive. */
 typedef struct vdrive_s {
@@ -185,6 +186,7 @@ typedef struct vdrive_s {
 
     unsigned int bam_size;
     uint8_t *bam;              /* Disk header blk (if any) followed by BAM blocks */
+    struct vdrive_dir_index_s *dir_index; /* cached directory, see vdrive-dir.c */
     bufferinfo_t buffers[16];
 
     /* Memory read command buffer.  */
@@ -35,6 +35,7 @@
 #include "resources.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "testbatch.h"
 
 #include "debugcart.h"
 
@@ -73,6 +74,9 @@ static const export_resource_t export_res = {
 
 static void debugcart_store(uint16_t addr, uint8_t value)
 {
+    if (testbatch_debugcart_exit((int)value)) {
+        return;
+    }
     fprintf(stdout, "DBGCART: exit(%d) cycles elapsed: %"PRIu64"\n",
             (int)value, maincpu_clk);
 
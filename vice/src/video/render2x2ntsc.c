@@ -28,6 +28,7 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "render2x2.h"
 #include "render2x2ntsc.h"
@@ -116,6 +117,9 @@ void render_generic_2x2_ntsc(video_render_color_tables_t *color_tab,
 
     int first_line = viewport_first_line * 2;
     int last_line = (viewport_last_line * 2) + 1;
+    int readable = config->readable;
+    unsigned int same = 0;
+    size_t srclen, trglen;
 
     src = src + pitchs * ys + xs - 2;
     trg = trg + pitcht * yt + xt * pixelstride;
@@ -125,6 +129,10 @@ void render_generic_2x2_ntsc(video_render_color_tables_t *color_tab,
     wlast = width & 1;
     width >>= 1;
 
+    /* source bytes read and target bytes written per line */
+    srclen = wfirst + width + 4;
+    trglen = (write_interpolated_pixels ? (width << 1) + wfirst + wlast : width + wlast) * pixelstride;
+
     /* That's all initialization we need for full lines. Unfortunately, for
      * scanlines we also need to calculate the RGB color of the previous
      * full line, and that requires initialization from 2 full lines above our
@@ -138,6 +146,25 @@ void render_generic_2x2_ntsc(video_render_color_tables_t *color_tab,
 
     /* height & 1 == 0. */
     for (y = yys; y < yys + height + 1; y += 2) {
+        /* count the source lines above this one with the same content */
+        if (y != yys && y != yys + height) {
+            same = memcmp(src, src - pitchs, srclen) == 0 ? same + 1 : 0;
+        }
+
+        /* A line repeating the two source lines above it renders exactly
+         * like the line above, scanline included, so copy that instead of
+         * rendering it again. */
+        if (readable && same >= 2
+            && y < yys + height
+            && y - 2 > (unsigned int)first_line
+            && y <= (unsigned int)last_line) {
+            memcpy(trg - pitcht, trg - pitcht * 3, trglen);
+            memcpy(trg, trg - pitcht * 2, trglen);
+            src += pitchs;
+            trg += pitcht * 2;
+            continue;
+        }
+
         /* when we are dealing with the last line, the rules change:
          * we no longer write the main output to screen, we just put it into
          * the scanline. */
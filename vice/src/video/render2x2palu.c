@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "render2x2.h"
 #include "render2x2palu.h"
@@ -109,6 +110,9 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
     int32_t l, l2, u, u2, unew, v, v2, vnew, off, off_flip, shade;
     int first_line = viewport_first_line * 2;
     int last_line = (viewport_last_line * 2) + 1;
+    int readable = config->readable;
+    unsigned int same = 0;
+    size_t srclen, trglen;
 
     src = src + pitchs * ys + xs - 2;
     trg = trg + pitcht * yt + xt * pixelstride;
@@ -118,6 +122,10 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
     wlast = width & 1;
     width >>= 1;
 
+    /* source bytes read and target bytes written per line */
+    srclen = wfirst + width + 4;
+    trglen = (write_interpolated_pixels ? (width << 1) + wfirst + wlast : width + wlast) * pixelstride;
+
     line = color_tab->line_yuv_0;
     /* get previous line into buffer. */
     tmpsrc = ys > 0 ? src - pitchs : src;
@@ -156,6 +164,29 @@ void render_generic_2x2_pal_u(video_render_color_tables_t *color_tab,
 
     /* height & 1 == 0. */
     for (y = yys; y < yys + height + 1; y += 2) {
+        /* count the source lines above this one with the same content */
+        if (y != yys && y != yys + height) {
+            same = memcmp(src, src - pitchs, srclen) == 0 ? same + 1 : 0;
+        }
+
+        /* Two lines repeating the four source lines above them render
+         * exactly like the two lines above, delay line and scanlines
+         * included, so copy those instead of rendering them again. */
+        if (readable && same >= 4
+            && y + 2 < yys + height
+            && y - 4 > (unsigned int)first_line
+            && y + 2 <= (unsigned int)last_line
+            && memcmp(src + pitchs, src, srclen) == 0) {
+            for (tmptrg = trg - pitcht; tmptrg < trg + pitcht * 3; tmptrg += pitcht) {
+                memcpy(tmptrg, tmptrg - pitcht * 4, trglen);
+            }
+            same++;
+            src += pitchs * 2;
+            trg += pitcht * 4;
+            y += 2;
+            continue;
+        }
+
         /* when we are dealing with the last line, the rules change:
          * we no longer write the main output to screen, we just put it into
          * the scanline. */
@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "archdep.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -111,6 +112,46 @@ void video_canvas_shutdown(video_canvas_t *canvas)
     }
 }
 
+/* Number of times the next frame is rendered again to time the renderer,
+   set by `-renderbench' */
+static int render_benchmark_frames = 0;
+
+void video_canvas_render_benchmark_set(int frames)
+{
+    render_benchmark_frames = frames;
+}
+
+/* Render the same frame `render_benchmark_frames' times in the current
+   render mode and log the time per frame.  Every mode and filter can be
+   timed this way by running the emulator once with each setting.  */
+static void video_canvas_render_benchmark(video_canvas_t *canvas, uint8_t *trg,
+                                          int width, int height, int xs, int ys,
+                                          int xt, int yt, int pitcht)
+{
+    video_render_config_t *config = canvas->videoconfig;
+    int frames = render_benchmark_frames;
+    tick_t start;
+    tick_t ticks;
+    int i;
+
+    render_benchmark_frames = 0;
+
+    start = tick_now();
+    for (i = 0; i < frames; i++) {
+        video_render_main(config, canvas->draw_buffer->draw_buffer,
+                          trg, width, height, xs, ys, xt, yt,
+                          canvas->draw_buffer->draw_buffer_width, pitcht,
+                          canvas->viewport);
+    }
+    ticks = tick_now_delta(start);
+
+    log_message(LOG_DEFAULT,
+                "Render benchmark: mode %d, filter %d, CRT type %d, %dx%d: %d frames in %u ms, %.3f ms per frame.",
+                config->rendermode, config->filter, canvas->viewport->crt_type,
+                width, height, frames, TICK_TO_MILLI(ticks),
+                (double)TICK_TO_MICRO(ticks) / 1000.0 / frames);
+}
+
 void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
                          int height, int xs, int ys, int xt, int yt,
                          int pitcht)
@@ -134,6 +175,10 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
                       trg, width, height, xs, ys, xt, yt,
                       canvas->draw_buffer->draw_buffer_width, pitcht,
                       viewport);
+
+    if (render_benchmark_frames > 0) {
+        video_canvas_render_benchmark(canvas, trg, width, height, xs, ys, xt, yt, pitcht);
+    }
 }
 
 /** \brief Force refresh all tracked canvases.
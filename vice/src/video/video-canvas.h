@@ -31,5 +31,6 @@ struct video_canvas_s;
 struct palette_s;
 
 int video_canvas_palette_set(struct video_canvas_s *canvas, struct palette_s *palette);
+void video_canvas_render_benchmark_set(int frames);
 
 #endif
@@ -27,6 +27,7 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "cmdline.h"
@@ -34,10 +35,36 @@
 #include "machine.h"
 #include "resources.h"
 #include "util.h"
+#include "video-canvas.h"
 #include "video.h"
 
+static int set_render_benchmark(const char *param, void *extra_param)
+{
+    int frames = atoi(param);
+
+    if (frames < 1) {
+        return -1;
+    }
+    video_canvas_render_benchmark_set(frames);
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-renderthreads", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "VideoRenderThreads", NULL,
+      "<Number>", "Number of threads rendering the video output (1-16)" },
+    { "-renderbench", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      set_render_benchmark, NULL, NULL, NULL,
+      "<Number>", "Render the first frame <Number> times in the current render mode and log the time per frame" },
+    CMDLINE_LIST_END
+};
+
 int video_cmdline_options_init(void)
 {
+    if (cmdline_register_options(cmdline_options) < 0) {
+        return -1;
+    }
     return video_arch_cmdline_options_init();
 }
 
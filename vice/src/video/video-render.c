@@ -27,8 +27,11 @@
 
 #include "vice.h"
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "lib.h"
 #include "log.h"
 #include "types.h"
 #include "video-render.h"
@@ -39,6 +42,23 @@ static render_pal_ntsc_func_t  render_pal_ntsc_func  = video_render_pal_ntsc_mai
 static render_rgbi_func_t render_rgbi_func = video_render_rgbi_main;
 static render_crt_mono_func_t render_crt_mono_func = video_render_crt_mono_main;
 
+/* Minimum number of source lines per band, smaller bands aren't worth the
+   thread synchronization */
+#define RENDER_BAND_MIN_LINES   16
+
+/* Number of threads rendering bands concurrently, 1 renders the whole area
+   on the calling thread */
+static int render_threads = 1;
+
+/* Copies of the render config for the bands after the first one, the
+   renderers keep per line state in the color tables */
+static video_render_config_t *band_configs[RENDER_BANDS_MAX];
+
+/* Config and color table generation each band config was last fully copied
+   from */
+static const video_render_config_t *band_config_source[RENDER_BANDS_MAX];
+static unsigned int band_config_generation[RENDER_BANDS_MAX];
+
 void video_render_initconfig(video_render_config_t *config)
 {
     int i;
@@ -67,39 +87,26 @@ void video_render_setphysicalcolor(video_render_config_t *config, int index,
             break;
     }
     config->color_tables.physical_colors[index] = color;
+    config->color_tables.generation++;
 }
 
 static int rendermode_error = -1;
 
-void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+/* Render an area with the renderer for the current rendermode, returns -1 if
+   the rendermode isn't supported */
+static int render_area(video_render_config_t *config, uint8_t *src, uint8_t *trg,
                        int width, int height, int xs, int ys, int xt, int yt,
                        int pitchs, int pitcht, viewport_t *viewport)
 {
-    int rendermode;
-
-#if 0
-    log_debug("w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
-              width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
-
-#endif
-    if (width <= 0) {
-        return; /* some render routines don't like invalid width */
-    }
-
-    video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
-
-    rendermode = config->rendermode;
-
-    switch (rendermode) {
+    switch (config->rendermode) {
         case VIDEO_RENDER_NULL:
-            return;
-            break;
+            return 0;
 
         case VIDEO_RENDER_PAL_NTSC_1X1:
         case VIDEO_RENDER_PAL_NTSC_2X2:
             render_pal_ntsc_func(config, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
                                  viewport->crt_type, viewport->first_line, viewport->last_line);
-            return;
+            return 0;
 
         case VIDEO_RENDER_CRT_MONO_1X1:
         case VIDEO_RENDER_CRT_MONO_1X2:
@@ -107,7 +114,7 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
         case VIDEO_RENDER_CRT_MONO_2X4:
             render_crt_mono_func(config, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
                                  viewport->first_line, viewport->last_line);
-            return;
+            return 0;
 
         case VIDEO_RENDER_RGBI_1X1:
         case VIDEO_RENDER_RGBI_1X2:
@@ -115,12 +122,156 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
         case VIDEO_RENDER_RGBI_2X4:
             render_rgbi_func(config, src, trg, width, height, xs, ys, xt, yt, pitchs, pitcht,
                              viewport->first_line, viewport->last_line);
-            return;
+            return 0;
+    }
+    return -1;
+}
+
+#ifdef _OPENMP
+/* Bring the config of band `band' up to date with `config'.  The color tables
+   make up almost all of the config and only change with the palette, so
+   they are only copied when their generation differs, otherwise just the
+   fields around them are.  */
+static void band_config_sync(int band, const video_render_config_t *config)
+{
+    video_render_config_t *band_config = band_configs[band];
+    size_t tables_start = offsetof(video_render_config_t, color_tables);
+    size_t tables_end = tables_start + sizeof(video_render_color_tables_t);
+
+    if (band_config_source[band] != config
+        || band_config_generation[band] != config->color_tables.generation) {
+        *band_config = *config;
+        band_config_source[band] = config;
+        band_config_generation[band] = config->color_tables.generation;
+        return;
+    }
+
+    memcpy(band_config, config, tables_start);
+    memcpy((uint8_t *)band_config + tables_end, (const uint8_t *)config + tables_end,
+           sizeof(video_render_config_t) - tables_end);
+}
+
+/* Split the area into horizontal bands and render those concurrently.
+ *
+ * The renderers work out the PAL delay line and the scanlines from the
+ * source line above the area and render the scanline below it, so bands
+ * rendered separately add up to the same output as the whole area. The one
+ * exception is a band ending right below the viewport, where the renderers
+ * repeat the last line for the scanline, so no band boundary goes there.
+ *
+ * Returns the number of bands rendered, 0 if the area wasn't split. */
+static int render_bands(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                        int width, int height, int xs, int ys, int xt, int yt,
+                        int pitchs, int pitcht, viewport_t *viewport)
+{
+    int bound[RENDER_BANDS_MAX + 1];
+    int result[RENDER_BANDS_MAX];
+    int scaley = config->scaley > 1 ? config->scaley : 1;
+    int lines = height / scaley;
+    int bands = render_threads;
+    int i;
+
+    if (bands > lines / RENDER_BAND_MIN_LINES) {
+        bands = lines / RENDER_BAND_MIN_LINES;
+    }
+    if (bands < 2) {
+        return 0;
+    }
+
+    /* band boundaries in source lines relative to ys */
+    bound[0] = 0;
+    for (i = 1; i < bands; i++) {
+        bound[i] = lines * i / bands;
+        if (ys + bound[i] == (int)viewport->last_line + 1) {
+            bound[i]--;
+        }
+    }
+    bound[bands] = lines;
+
+    for (i = 1; i < bands; i++) {
+        if (band_configs[i] == NULL) {
+            band_configs[i] = lib_malloc(sizeof(video_render_config_t));
+            band_config_source[i] = NULL;
+        }
+        band_config_sync(i, config);
     }
-    if (rendermode_error != rendermode) {
-        log_error(LOG_DEFAULT, "video_render_main: unsupported rendermode (%d)", rendermode);
+
+#pragma omp parallel for num_threads(bands) schedule(static, 1)
+    for (i = 0; i < bands; i++) {
+        video_render_config_t *band_config = i == 0 ? config : band_configs[i];
+        int band_height = i == bands - 1
+                          ? height - bound[i] * scaley
+                          : (bound[i + 1] - bound[i]) * scaley;
+
+        result[i] = render_area(band_config, src, trg, width, band_height,
+                                xs, ys + bound[i], xt, yt + bound[i] * scaley,
+                                pitchs, pitcht, viewport);
+    }
+
+    for (i = 0; i < bands; i++) {
+        if (result[i] < 0) {
+            return -1;
+        }
+    }
+    return bands;
+}
+#endif
+
+void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                       int width, int height, int xs, int ys, int xt, int yt,
+                       int pitchs, int pitcht, viewport_t *viewport)
+{
+    int result = 0;
+
+#if 0
+    log_debug("w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
+              width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
+
+#endif
+    if (width <= 0) {
+        return; /* some render routines don't like invalid width */
+    }
+
+    video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
+
+    if (config->rendermode == VIDEO_RENDER_NULL) {
+        return;
+    }
+
+#ifdef _OPENMP
+    if (render_threads > 1) {
+        result = render_bands(config, src, trg, width, height, xs, ys, xt, yt,
+                              pitchs, pitcht, viewport);
+    }
+#endif
+    if (result == 0) {
+        result = render_area(config, src, trg, width, height, xs, ys, xt, yt,
+                             pitchs, pitcht, viewport);
+    }
+    if (result < 0) {
+        if (rendermode_error != config->rendermode) {
+            log_error(LOG_DEFAULT, "video_render_main: unsupported rendermode (%d)", config->rendermode);
+        }
+        rendermode_error = config->rendermode;
+    }
+}
+
+/* Set the number of threads rendering a frame in bands */
+void video_render_threads_set(int threads)
+{
+    render_threads = threads;
+}
+
+/* Free the band render configs */
+void video_render_shutdown(void)
+{
+    int i;
+
+    for (i = 0; i < RENDER_BANDS_MAX; i++) {
+        lib_free(band_configs[i]);
+        band_configs[i] = NULL;
+        band_config_source[i] = NULL;
     }
-    rendermode_error = rendermode;
 }
 
 void video_render_palntscfunc_set(render_pal_ntsc_func_t func)
@@ -35,6 +35,10 @@
 struct video_render_config_s;
 struct video_canvas_s;
 
+/* Maximum number of horizontal bands a frame is split into, which is also
+   the maximum number of render threads */
+#define RENDER_BANDS_MAX        16
+
 typedef void (*render_pal_ntsc_func_t)(video_render_config_t *, uint8_t *, uint8_t *,
                                   int, int, int, int,
                                   int, int, int, int,
@@ -58,6 +62,9 @@ void video_render_main(struct video_render_config_s *config, uint8_t *src,
                        viewport_t *viewport);
 void video_render_update_palette(struct video_canvas_s *canvas);
 
+void video_render_threads_set(int threads);
+void video_render_shutdown(void);
+
 void video_render_palntscfunc_set(render_pal_ntsc_func_t func);
 void video_render_crtmonofunc_set(render_crt_mono_func_t func);
 void video_render_rgbifunc_set(render_rgbi_func_t func);
@@ -64,7 +64,9 @@
 #endif
 #include "network.h"
 #include "resources.h"
+#include "rewind.h"
 #include "sound.h"
+#include "testbatch.h"
 #include "types.h"
 #include "videoarch.h"
 #include "vsync.h"
@@ -681,6 +683,10 @@ void vsync_do_vsync(struct video_canvas_s *c)
 
     vsync_hook();
 
+    rewind_vsync_hook();
+
+    testbatch_vsync_hook();
+
     if (network_connected()) {
         /* TODO - re-eval if any of this network stuff makes sense */
         network_hook_time = tick_now_delta(network_hook_time);
@@ -93,6 +93,7 @@ struct zfile_s {
     struct zfile_s *prev, *next; /* Link to the previous and next nodes.  */
     zfile_action_t action;       /* action on close */
     char *request_string;        /* ui string for action=ZFILE_REQUEST */
+    uint8_t *data;               /* Buffer behind an in-memory stream.  */
 };
 typedef struct zfile_s zfile_t;
 
@@ -104,6 +105,26 @@ static log_t zlog = LOG_ERR;
 
 static int zinit_done = 0;
 
+#ifdef HAVE_ZLIB
+/* Recently uncompressed gzip files, kept so that opening the same image
+   several times in a row (as autostart and the image type detection do)
+   only inflates it once.  Entries are keyed by the full path plus size and
+   modification time of the compressed file, most recently used first.  */
+#define ZFILE_CACHE_ENTRIES     8
+#define ZFILE_CACHE_MAX_BYTES   (32 * 1024 * 1024)
+
+typedef struct zfile_cache_s {
+    char *name;         /* Full path of the compressed file.  */
+    size_t file_size;   /* Size of the compressed file.  */
+    time_t mtime;       /* Modification time of the compressed file.  */
+    uint8_t *data;      /* Uncompressed data.  */
+    size_t size;        /* Size of the uncompressed data.  */
+} zfile_cache_t;
+
+static zfile_cache_t zfile_cache[ZFILE_CACHE_ENTRIES];
+static int zfile_cache_count = 0;
+static size_t zfile_cache_bytes = 0;
+#endif
 
 /** \@brief 'Check' is file \a name is a gzip or compress file
  *
@@ -136,6 +157,7 @@ static void zfile_list_destroy(void)
 
         lib_free(p->orig_name);
         lib_free(p->tmp_name);
+        lib_free(p->data);
         next = p->next;
         lib_free(p);
         p = next;
@@ -177,6 +199,7 @@ static void zfile_list_add(const char *tmp_name,
     new_zfile->type = type;
     new_zfile->action = ZFILE_KEEP;
     new_zfile->request_string = NULL;
+    new_zfile->data = NULL;
     new_zfile->next = zfile_list;
     new_zfile->prev = NULL;
     if (zfile_list != NULL) {
@@ -185,15 +208,182 @@ static void zfile_list_add(const char *tmp_name,
     zfile_list = new_zfile;
 }
 
+/* ------------------------------------------------------------------------ */
+
+/* Cache of uncompressed files.  */
+
+#ifdef HAVE_ZLIB
+static void zfile_cache_remove(int i)
+{
+    zfile_cache_bytes -= zfile_cache[i].size;
+    lib_free(zfile_cache[i].name);
+    lib_free(zfile_cache[i].data);
+
+    zfile_cache_count--;
+    memmove(&zfile_cache[i], &zfile_cache[i + 1],
+            (size_t)(zfile_cache_count - i) * sizeof(zfile_cache_t));
+}
+
+static void zfile_cache_destroy(void)
+{
+    while (zfile_cache_count > 0) {
+        zfile_cache_remove(zfile_cache_count - 1);
+    }
+}
+
+/* Drop the cached copy of `fullname', if any.  */
+static void zfile_cache_forget(const char *fullname)
+{
+    int i;
+
+    for (i = 0; i < zfile_cache_count; i++) {
+        if (!strcmp(zfile_cache[i].name, fullname)) {
+            zfile_cache_remove(i);
+            return;
+        }
+    }
+}
+
+/* Look up `fullname' and move it to the front of the cache.  Return a copy
+   of the uncompressed data, or NULL if the file is not cached or has
+   changed since.  */
+static uint8_t *zfile_cache_lookup(const char *fullname, size_t file_size,
+                                   time_t mtime, size_t *size)
+{
+    zfile_cache_t entry;
+    uint8_t *data;
+    int i;
+
+    for (i = 0; i < zfile_cache_count; i++) {
+        if (!strcmp(zfile_cache[i].name, fullname)) {
+            break;
+        }
+    }
+
+    if (i == zfile_cache_count) {
+        return NULL;
+    }
+
+    if (zfile_cache[i].file_size != file_size || zfile_cache[i].mtime != mtime) {
+        zfile_cache_remove(i);
+        return NULL;
+    }
+
+    entry = zfile_cache[i];
+    memmove(&zfile_cache[1], &zfile_cache[0], (size_t)i * sizeof(zfile_cache_t));
+    zfile_cache[0] = entry;
+
+    data = lib_malloc(entry.size);
+    memcpy(data, entry.data, entry.size);
+    *size = entry.size;
+
+    return data;
+}
+
+/* Add a copy of `data' to the front of the cache, evicting the least
+   recently used entries to make room.  */
+static void zfile_cache_insert(const char *fullname, size_t file_size,
+                               time_t mtime, const uint8_t *data, size_t size)
+{
+    if (size > ZFILE_CACHE_MAX_BYTES) {
+        return;
+    }
+
+    zfile_cache_forget(fullname);
+
+    while (zfile_cache_count == ZFILE_CACHE_ENTRIES
+           || zfile_cache_bytes + size > ZFILE_CACHE_MAX_BYTES) {
+        zfile_cache_remove(zfile_cache_count - 1);
+    }
+
+    memmove(&zfile_cache[1], &zfile_cache[0],
+            (size_t)zfile_cache_count * sizeof(zfile_cache_t));
+    zfile_cache[0].name = lib_strdup(fullname);
+    zfile_cache[0].file_size = file_size;
+    zfile_cache[0].mtime = mtime;
+    zfile_cache[0].data = lib_malloc(size);
+    memcpy(zfile_cache[0].data, data, size);
+    zfile_cache[0].size = size;
+
+    zfile_cache_count++;
+    zfile_cache_bytes += size;
+}
+#endif
+
 void zfile_shutdown(void)
 {
     zfile_list_destroy();
+#ifdef HAVE_ZLIB
+    zfile_cache_destroy();
+#endif
 }
 
 /* ------------------------------------------------------------------------ */
 
 /* Uncompression.  */
 
+#ifdef HAVE_ZLIB
+/* Uncompress the gzip file `name' into memory, taking it from the cache if
+   the file has not changed since it was last uncompressed.  Return a buffer
+   owned by the caller and its size in `size', or NULL on error.  */
+static uint8_t *uncompress_gzip_to_memory(const char *name, size_t *size)
+{
+    char *fullname = NULL;
+    size_t file_size;
+    time_t mtime;
+    gzFile fdsrc;
+    uint8_t *data;
+    size_t data_size = 0;
+    size_t alloc_size = 0x10000;
+    int len;
+
+    archdep_expand_path(&fullname, name);
+
+    if (archdep_stat(fullname, &file_size, NULL) < 0
+        || archdep_stat_mtime(fullname, &mtime) < 0) {
+        lib_free(fullname);
+        return NULL;
+    }
+
+    data = zfile_cache_lookup(fullname, file_size, mtime, size);
+    if (data != NULL) {
+        ZDEBUG(("uncompress_gzip_to_memory: `%s' found in cache", fullname));
+        lib_free(fullname);
+        return data;
+    }
+
+    fdsrc = gzopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        lib_free(fullname);
+        return NULL;
+    }
+
+    data = lib_malloc(alloc_size);
+    do {
+        if (data_size == alloc_size) {
+            alloc_size *= 2;
+            data = lib_realloc(data, alloc_size);
+        }
+        len = gzread(fdsrc, data + data_size, (unsigned int)(alloc_size - data_size));
+        if (len > 0) {
+            data_size += (size_t)len;
+        }
+    } while (len > 0);
+
+    gzclose(fdsrc);
+
+    /* Like gzip itself, hand out whatever could be read from a damaged file,
+       but do not keep it around.  */
+    if (len == 0) {
+        zfile_cache_insert(fullname, file_size, mtime, data, data_size);
+    }
+    lib_free(fullname);
+
+    *size = data_size;
+    return data;
+}
+#endif
+
 /* If `name' has a gzip-like extension, try to uncompress it into a temporary
    file using gzip or zlib if available.  If this succeeds, return the name
    of the temporary file; return NULL otherwise.  */
@@ -201,45 +391,36 @@ static char *try_uncompress_with_gzip(const char *name)
 {
 #ifdef HAVE_ZLIB
     FILE *fddest;
-    gzFile fdsrc;
     char *tmp_name = NULL;
-    int len;
+    uint8_t *data;
+    size_t size;
 
     if (!file_is_gzip(name)) {
         return NULL;
     }
 
+    data = uncompress_gzip_to_memory(name, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+
     fddest = archdep_mkstemp_fd(&tmp_name, MODE_WRITE);
 
     if (fddest == NULL) {
+        lib_free(data);
         return NULL;
     }
 
-    fdsrc = gzopen(name, MODE_READ);
-    if (fdsrc == NULL) {
+    if (fwrite(data, 1, size, fddest) < size) {
         fclose(fddest);
         archdep_remove(tmp_name);
         lib_free(tmp_name);
+        lib_free(data);
         return NULL;
     }
 
-    do {
-        char buf[256];
-
-        len = gzread(fdsrc, (void *)buf, 256);
-        if (len > 0) {
-            if (fwrite((void *)buf, 1, (size_t)len, fddest) < len) {
-                gzclose(fdsrc);
-                fclose(fddest);
-                archdep_remove(tmp_name);
-                lib_free(tmp_name);
-                return NULL;
-            }
-        }
-    } while (len > 0);
-
-    gzclose(fdsrc);
     fclose(fddest);
+    lib_free(data);
 
     return tmp_name;
 #else
@@ -774,6 +955,48 @@ static const valid_archives_t valid_archives[] = {
     { NULL, NULL, NULL, NULL, NULL }
 };
 
+#if defined(HAVE_ZLIB) && defined(HAVE_FMEMOPEN)
+/* If `name' is a gzip file that is not also an archive, uncompress it into
+   memory and return a stream reading from that buffer, so opening it for
+   reading needs no temporary file.  The buffer is returned in `data' and
+   must be kept until the stream is closed.  Return NULL if this is not
+   possible.  */
+static FILE *try_uncompress_to_memory(const char *name, const char *mode,
+                                      uint8_t **data)
+{
+    FILE *stream;
+    size_t size;
+    int i;
+
+    if (!file_is_gzip(name)) {
+        return NULL;
+    }
+
+    for (i = 0; valid_archives[i].program; i++) {
+        size_t l = strlen(name);
+        size_t e = strlen(valid_archives[i].extension);
+
+        if (l >= e && !util_strcasecmp(name + l - e, valid_archives[i].extension)) {
+            return NULL;
+        }
+    }
+
+    *data = uncompress_gzip_to_memory(name, &size);
+    if (*data == NULL) {
+        return NULL;
+    }
+
+    /* fmemopen() refuses empty buffers, let the caller fall back */
+    stream = size ? fmemopen(*data, size, mode) : NULL;
+    if (stream == NULL) {
+        lib_free(*data);
+        *data = NULL;
+    }
+
+    return stream;
+}
+#endif
+
 /* Try to uncompress file `name' using the algorithms we know of.  If this is
    not possible, return `COMPR_NONE'.  Otherwise, uncompress the file into a
    temporary file, return the type of algorithm used and the name of the
@@ -1057,6 +1280,19 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
+#if defined(HAVE_ZLIB) && defined(HAVE_FMEMOPEN)
+    if (!write_mode) {
+        uint8_t *data;
+
+        stream = try_uncompress_to_memory(name, mode, &data);
+        if (stream != NULL) {
+            zfile_list_add(NULL, name, COMPR_GZIP, write_mode, stream, NULL);
+            zfile_list->data = data;
+            return stream;
+        }
+    }
+#endif
+
     type = try_uncompress(name, &tmp_name, write_mode);
     if (type == COMPR_NONE) {
         stream = fopen(name, mode);
@@ -1124,6 +1360,13 @@ static int handle_close(zfile_t *ptr)
             return -1;
         }
 
+#ifdef HAVE_ZLIB
+        /* The modification time alone may not tell the new contents apart */
+        if (ptr->orig_name && ptr->write_mode) {
+            zfile_cache_forget(ptr->orig_name);
+        }
+#endif
+
         /* Remove temporary file.  */
         if (archdep_remove(ptr->tmp_name) < 0) {
             log_error(zlog, "Cannot unlink `%s': %s", ptr->tmp_name, strerror(errno));
@@ -1152,6 +1395,9 @@ static int handle_close(zfile_t *ptr)
     if (ptr->request_string) {
         lib_free(ptr->request_string);
     }
+    if (ptr->data) {
+        lib_free(ptr->data);
+    }
 
     lib_free(ptr);
 